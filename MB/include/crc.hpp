@@ -6,6 +6,12 @@
 
 //! This namespace contains functions used for CRC calculation
 namespace MB::CRC {
+//! Initial register value of CRC-16/MODBUS
+constexpr uint16_t initialValue = 0xFFFF;
+
+//! Feeds len bytes into a running CRC-16/MODBUS value and returns the new value
+uint16_t update(uint16_t crc, const uint8_t *buff, std::size_t len) noexcept;
+
 //! Calculates CRC based on the input buffer - C style
 uint16_t calculateCRC(const uint8_t *buff, std::size_t len);
 
@@ -17,7 +23,27 @@ inline uint16_t calculateCRC(const std::vector<uint8_t> &buffer,
         bufferLength = *len;
     }
 
-    return calculateCRC(static_cast<const uint8_t *>(&(*buffer.begin())), bufferLength);
+    return calculateCRC(buffer.data(), bufferLength);
 }
+
+/**
+ * Incremental CRC-16/MODBUS calculator, useful when a frame arrives in several chunks:
+ *
+ *     MB::CRC::Crc16 crc;
+ *     crc.update(first, firstLen);
+ *     crc.update(second, secondLen);
+ *     bool valid = crc.value() == expected;
+ */
+class Crc16 {
+  public:
+    void update(const uint8_t *buff, std::size_t len) noexcept { _crc = CRC::update(_crc, buff, len); }
+    void update(const std::vector<uint8_t> &buffer) noexcept { update(buffer.data(), buffer.size()); }
+    void reset() noexcept { _crc = initialValue; }
+
+    [[nodiscard]] uint16_t value() const noexcept { return _crc; }
+
+  private:
+    uint16_t _crc = initialValue;
+};
 }; // namespace MB::CRC
 #endif // MB_CRC_HPP
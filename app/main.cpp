@@ -17,6 +17,7 @@ struct StartupOptions {
     std::string mode = "api";                 // api | headless
     std::string bindAddress = "0.0.0.0";
     std::uint16_t apiPort = 8001;
+    std::size_t apiWorkers = api::HttpServerOptions{}.workerThreads;
 
     std::string startupTransport = "none";    // none | tcp | rtu
     std::string tcpHost = "127.0.0.1";
@@ -26,6 +27,15 @@ struct StartupOptions {
     std::uint32_t rtuBaud = 9600;
     std::uint8_t rtuStopBits = 1;
 
+    std::size_t tcpWindow = 1;
+    std::size_t ioThreads = 1;
+    std::size_t workerThreads = application::TaskScheduler::kDefaultWorkers;
+    std::size_t maxWriteBytes = transport::kDefaultMaxWriteBytes;
+    std::uint32_t connectTimeoutMs = 3000;
+    std::uint16_t readMaxGap = application::ReadPlanner::kDefaultGapLimit;
+    std::uint32_t drainWindowMs = static_cast<std::uint32_t>(application::ApplicationCore::kDefaultDrainWindow.count());
+    std::size_t changeLogSize = application::RegisterCache::kDefaultChangeLogCapacity;
+
     bool verboseModbus = false;
     bool showHelp = false;
 };
@@ -37,11 +47,20 @@ void printUsage() {
         << "  --mode <api|headless>          Run mode (default: api)\n"
         << "  --bind <ip>                    API bind address (default: 0.0.0.0)\n"
         << "  --api-port <port>              API TCP port (default: 8080)\n"
+        << "  --api-workers <n>              Threads running JSON-RPC calls concurrently (default: 8)\n"
         << "  --transport <none|tcp|rtu>     Transport opened on startup (default: none)\n"
+        << "  --io-threads <n>               Transport I/O threads (default: 1)\n"
+        << "  --worker-threads <n>           Application worker threads (default: 4)\n"
+        << "  --connect-timeout-ms <ms>      Startup transport connect deadline (default: 3000)\n"
+        << "  --max-write-bytes <n>          Cap for one coalesced transport write (default: 8192)\n"
+        << "  --read-max-gap <0..125>        Max register gap bridged when merging group reads (default: 32)\n"
+        << "  --drain-window-ms <ms>         How long a timed-out request waits to drop its late reply (default: 250)\n"
+        << "  --change-log-size <n>          Register changes kept for modbus.changes_since (default: 65536)\n"
         << "\n"
         << "  TCP startup parameters:\n"
         << "    --tcp-host <ip>              TCP host (default: 127.0.0.1)\n"
         << "    --tcp-port <port>            TCP port (default: 502)\n"
+        << "    --tcp-window <1..32>         Max pipelined requests per TCP session (default: 1)\n"
         << "\n"
         << "  RTU startup parameters:\n"
         << "    --rtu-port <path_or_name>    Serial port, e.g. /dev/ttyUSB0 or COM3\n"
@@ -111,12 +130,57 @@ std::optional<StartupOptions> parseArgs(int argc, char* argv[], std::string& err
             }
             continue;
         }
+        if (arg == "--api-workers") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.apiWorkers) || options.apiWorkers < 1 || options.apiWorkers > 256) {
+                error = "Invalid --api-workers value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
         if (arg == "--transport") {
             auto value = getValue(arg);
             if (!value) return std::nullopt;
             options.startupTransport = *value;
             continue;
         }
+        if (arg == "--io-threads") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.ioThreads) || options.ioThreads < 1 || options.ioThreads > 64) {
+                error = "Invalid --io-threads value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (arg == "--worker-threads") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.workerThreads) || options.workerThreads < 1 || options.workerThreads > 64) {
+                error = "Invalid --worker-threads value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (arg == "--connect-timeout-ms") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.connectTimeoutMs) || options.connectTimeoutMs == 0) {
+                error = "Invalid --connect-timeout-ms value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (arg == "--max-write-bytes") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.maxWriteBytes) || options.maxWriteBytes == 0) {
+                error = "Invalid --max-write-bytes value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
         if (arg == "--tcp-host") {
             auto value = getValue(arg);
             if (!value) return std::nullopt;
@@ -132,6 +196,43 @@ std::optional<StartupOptions> parseArgs(int argc, char* argv[], std::string& err
             }
             continue;
         }
+        if (arg == "--read-max-gap") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.readMaxGap) || options.readMaxGap > protocol::kMaxReadRegisters) {
+                error = "Invalid --read-max-gap value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (arg == "--drain-window-ms") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.drainWindowMs) || options.drainWindowMs > 60000) {
+                error = "Invalid --drain-window-ms value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (arg == "--change-log-size") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.changeLogSize) || options.changeLogSize < 1 || options.changeLogSize > 16777216) {
+                error = "Invalid --change-log-size value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
+        if (arg == "--tcp-window") {
+            auto value = getValue(arg);
+            if (!value) return std::nullopt;
+            if (!parseUnsigned(*value, options.tcpWindow) || options.tcpWindow < 1 ||
+                options.tcpWindow > application::ApplicationCore::kMaxInFlightLimit) {
+                error = "Invalid --tcp-window value: " + *value;
+                return std::nullopt;
+            }
+            continue;
+        }
         if (arg == "--rtu-port") {
             auto value = getValue(arg);
             if (!value) return std::nullopt;
@@ -193,9 +294,9 @@ bool openStartupTransport(application::ApplicationCore& appCore, const StartupOp
     bool opened = false;
 
     if (options.startupTransport == "tcp") {
-        opened = appCore.openTcpTransport(options.tcpHost, options.tcpPort, error);
+        opened = appCore.openTcpTransport(options.tcpHost, options.tcpPort, error, options.connectTimeoutMs);
     } else {
-        opened = appCore.openRtuTransport(options.rtuPort, options.rtuBaud, options.rtuStopBits, error);
+        opened = appCore.openRtuTransport(options.rtuPort, options.rtuBaud, options.rtuStopBits, error, options.connectTimeoutMs);
     }
 
     if (!opened) {
@@ -221,8 +322,15 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    transport::TransportManager transportManager;
-    application::ApplicationCore appCore(transportManager);
+    transport::TransportOptions transportOptions;
+    transportOptions.ioThreads = options.ioThreads;
+    transportOptions.maxWriteBytes = options.maxWriteBytes;
+    transport::TransportManager transportManager(transportOptions);
+    application::ApplicationCore appCore(transportManager, options.workerThreads);
+    appCore.setMaxInFlight(options.tcpWindow);
+    appCore.setReadGapLimit(options.readMaxGap);
+    appCore.setDrainWindow(std::chrono::milliseconds(options.drainWindowMs));
+    appCore.registerCache().setChangeLogCapacity(options.changeLogSize);
 
     if (options.verboseModbus) {
         appCore.setJsonResponseCallback([](const boost::json::value& response) {
@@ -239,7 +347,9 @@ int main(int argc, char* argv[]) {
 
     std::optional<api::HttpJsonServer> server;
     if (options.mode == "api") {
-        server.emplace(appCore, options.bindAddress, options.apiPort);
+        api::HttpServerOptions serverOptions;
+        serverOptions.workerThreads = options.apiWorkers;
+        server.emplace(appCore, options.bindAddress, options.apiPort, serverOptions);
         server->start();
         std::cout << "HTTP JSON API started on " << options.bindAddress << ':' << options.apiPort << std::endl;
     }
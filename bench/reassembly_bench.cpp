@@ -0,0 +1,144 @@
+// Reassembly throughput of StreamDecoder/ByteRing: read responses of random size are fed to
+// ProtocolHandler::processIncomingBuffer in chunks that split frames apart or coalesce many of them,
+// the way a session's 2 KiB reads deliver them.
+//
+//     reassembly_bench [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "crc.hpp"
+#include "layers/protocol/protocol_layer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kReadBufferSize = 2048;  // Session::readBuffer_
+constexpr int kRepeats = 5;
+
+enum class Chunking { Split, Coalesced, Random };
+
+const char* chunkingName(Chunking chunking) {
+    switch (chunking) {
+        case Chunking::Split:
+            return "split";
+        case Chunking::Coalesced:
+            return "coalesced";
+        case Chunking::Random:
+            return "random";
+    }
+    return "";
+}
+
+// A holding-register read response of `registers` values, as a TCP or RTU ADU.
+void appendFrame(std::vector<std::uint8_t>& out, transport::ConnectionType type, std::uint16_t transactionId,
+                 std::uint16_t registers, std::mt19937& rng) {
+    const auto start = out.size();
+    const auto byteCount = static_cast<std::uint8_t>(registers * 2);
+    if (type == transport::ConnectionType::Tcp) {
+        const auto length = static_cast<std::uint16_t>(3 + byteCount);
+        out.insert(out.end(), {static_cast<std::uint8_t>(transactionId >> 8), static_cast<std::uint8_t>(transactionId), 0, 0,
+                               static_cast<std::uint8_t>(length >> 8), static_cast<std::uint8_t>(length)});
+    }
+    out.insert(out.end(), {1, static_cast<std::uint8_t>(protocol::FunctionCode::ReadHoldingRegisters), byteCount});
+    for (std::uint16_t i = 0; i < byteCount; ++i) {
+        out.push_back(static_cast<std::uint8_t>(rng()));
+    }
+    if (type == transport::ConnectionType::Rtu) {
+        const auto crc = MB::CRC::calculateCRC(out.data() + start, out.size() - start);
+        out.push_back(static_cast<std::uint8_t>(crc & 0xFF));
+        out.push_back(static_cast<std::uint8_t>(crc >> 8));
+    }
+}
+
+// Split: every read carries a few bytes, so nearly every frame is reassembled in the ring.
+// Coalesced: every read is a full receive buffer, so most frames decode in place.
+std::vector<std::size_t> makeChunks(std::size_t total, Chunking chunking, std::mt19937& rng) {
+    std::vector<std::size_t> chunks;
+    std::uniform_int_distribution<std::size_t> small(1, 16);
+    std::uniform_int_distribution<std::size_t> any(1, kReadBufferSize);
+    for (std::size_t done = 0; done < total;) {
+        std::size_t size = kReadBufferSize;
+        if (chunking == Chunking::Split) {
+            size = small(rng);
+        } else if (chunking == Chunking::Random) {
+            size = any(rng);
+        }
+        size = std::min(size, total - done);
+        chunks.push_back(size);
+        done += size;
+    }
+    return chunks;
+}
+
+struct Result {
+    double framesPerSecond = 0.0;
+    double megabytesPerSecond = 0.0;
+    bool complete = false;
+};
+
+Result run(transport::ConnectionType type, const std::vector<std::uint8_t>& bytes, std::size_t frames,
+           const std::vector<std::size_t>& chunks) {
+    Result result;
+    result.complete = true;
+    double best = 0.0;
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        protocol::ProtocolHandler handler;
+        auto decoder = handler.createDecoder(type);
+        std::size_t decoded = 0;
+        const protocol::ProtocolHandler::ResponseHandler onResponse = [&decoded](const protocol::ModbusResponse&) { ++decoded; };
+
+        const auto started = Clock::now();
+        std::size_t offset = 0;
+        for (const auto size : chunks) {
+            handler.processIncomingBuffer(*decoder, transport::ByteSpan{bytes.data() + offset, size}, onResponse);
+            offset += size;
+        }
+        const std::chrono::duration<double> elapsed = Clock::now() - started;
+
+        result.complete = result.complete && decoded == frames;
+        const double seconds = std::max(elapsed.count(), 1e-9);
+        if (best == 0.0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    result.framesPerSecond = static_cast<double>(frames) / best;
+    result.megabytesPerSecond = static_cast<double>(bytes.size()) / best / 1e6;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (frames == 0) {
+        std::fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    std::printf("%-4s %-10s %14s %10s\n", "type", "chunks", "frames/s", "MB/s");
+    for (const auto type : {transport::ConnectionType::Tcp, transport::ConnectionType::Rtu}) {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> registers(1, protocol::kMaxReadRegisters);
+        std::vector<std::uint8_t> bytes;
+        for (std::size_t i = 0; i < frames; ++i) {
+            appendFrame(bytes, type, static_cast<std::uint16_t>(i), static_cast<std::uint16_t>(registers(rng)), rng);
+        }
+
+        for (const auto chunking : {Chunking::Split, Chunking::Coalesced, Chunking::Random}) {
+            const auto result = run(type, bytes, frames, makeChunks(bytes.size(), chunking, rng));
+            std::printf("%-4s %-10s %14.0f %10.1f%s\n", type == transport::ConnectionType::Tcp ? "tcp" : "rtu",
+                        chunkingName(chunking), result.framesPerSecond, result.megabytesPerSecond,
+                        result.complete ? "" : "  (frames lost)");
+            ok = ok && result.complete;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -1,18 +1,38 @@
 #include "api_layer.h"
 
 #include <boost/beast/version.hpp>
+#include <boost/beast/websocket.hpp>
 
+#include <algorithm>
 #include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <optional>
 
 namespace api {
 
 namespace beast = boost::beast;
 namespace http = beast::http;
+namespace websocket = beast::websocket;
 namespace json = boost::json;
 using tcp = boost::asio::ip::tcp;
 
 namespace {
 
+// Runs `task` on `executor` and waits for it; the executor's io threads must be running.
+template <typename Executor, typename Task>
+void runOn(const Executor& executor, Task task) {
+    std::promise<void> done;
+    boost::asio::post(executor, [&done, &task]() {
+        task();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
 bool parseUint16Flexible(const json::value& value, std::uint16_t& out) {
     if (value.is_int64()) {
         const auto v = value.as_int64();
@@ -65,10 +85,168 @@ bool parseAddressField(const json::object& obj, std::uint16_t& out) {
     return parseUint16Flexible(obj.at("address"), out);
 }
 
+json::object readResultToJson(const application::ReadResult& result) {
+    json::array values;
+    values.reserve(result.values.size());
+    for (const auto value : result.values) {
+        values.emplace_back(value);
+    }
+
+    json::object obj;
+    obj["ok"] = true;
+    obj["slave_id"] = result.slaveId;
+    obj["address"] = result.address;
+    obj["count"] = result.count;
+    obj["function"] = protocol::ProtocolHandler::functionToString(result.function);
+    obj["values"] = std::move(values);
+    return obj;
+}
+
+bool parsePollItem(const json::object& obj, application::PollItemConfig& config) {
+    if (!parseUint8Strict(obj, "slave_id", config.slaveId) || !parseAddressField(obj, config.address) ||
+        !obj.contains("count") || !obj.at("count").is_int64() || !obj.contains("period_ms") || !obj.at("period_ms").is_int64()) {
+        return false;
+    }
+    const auto count = obj.at("count").as_int64();
+    const auto period = obj.at("period_ms").as_int64();
+    if (count < 0 || count > 0xFFFF || period < 0) {
+        return false;
+    }
+    config.count = static_cast<std::uint16_t>(count);
+    config.period = std::chrono::milliseconds(period);
+    config.function = obj.contains("input") && obj.at("input").is_bool() && obj.at("input").as_bool()
+                          ? protocol::FunctionCode::ReadInputRegisters
+                          : protocol::FunctionCode::ReadHoldingRegisters;
+    return true;
+}
+
+std::int64_t toUnixMs(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+}
+
+json::object pollItemToJson(const application::PollItemState& item) {
+    json::object obj;
+    obj["id"] = item.id;
+    obj["slave_id"] = item.config.slaveId;
+    obj["function"] = protocol::ProtocolHandler::functionToString(item.config.function);
+    obj["address"] = item.config.address;
+    obj["count"] = item.config.count;
+    obj["period_ms"] = item.config.period.count();
+    obj["scans"] = item.scans;
+    obj["errors"] = item.errors;
+    obj["overruns"] = item.overruns;
+    obj["jitter_avg_us"] = item.jitterAvgUs;
+    obj["jitter_max_us"] = item.jitterMaxUs;
+    return obj;
+}
+
+json::object pollValueToJson(const application::PollItemState& item) {
+    json::object obj;
+    obj["id"] = item.id;
+    obj["ok"] = item.lastOk;
+    obj["slave_id"] = item.config.slaveId;
+    obj["function"] = protocol::ProtocolHandler::functionToString(item.config.function);
+    obj["address"] = item.config.address;
+    obj["count"] = item.config.count;
+    if (!item.lastOk && !item.lastError.empty()) {
+        obj["error"] = item.lastError;
+    }
+    if (item.hasValue) {
+        json::array values;
+        values.reserve(item.latest.values.size());
+        for (const auto value : item.latest.values) {
+            values.emplace_back(value);
+        }
+        obj["values"] = std::move(values);
+        obj["timestamp_ms"] = toUnixMs(item.sampledAt);
+        obj["age_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - item.sampledAt).count();
+    } else {
+        obj["values"] = nullptr;
+    }
+    return obj;
+}
+
+json::value rpcError(const json::value& id, int code, const std::string& message) {
+    json::object r;
+    r["jsonrpc"] = "2.0";
+    r["id"] = id;
+    json::object e;
+    e["code"] = code;
+    e["message"] = message;
+    r["error"] = e;
+    return r;
+}
+
+json::value rpcResult(const json::value& id, const json::value& result) {
+    json::object r;
+    r["jsonrpc"] = "2.0";
+    r["id"] = id;
+    r["result"] = result;
+    return r;
+}
+
+constexpr std::size_t kDefaultChangeLimit = 10000;
+constexpr std::size_t kMaxChangeLimit = 100000;
+
+// Where a batch item may run: in the lane of one slave, on its own, or alone after everything before it.
+struct BatchKey {
+    enum class Kind { Free, Slave, Barrier };
+    Kind kind = Kind::Free;
+    std::int64_t slaveId = 0;
+};
+
+BatchKey batchKeyOf(const json::object& req) {
+    if (!req.contains("method") || !req.at("method").is_string()) {
+        return {};
+    }
+    // Read-only methods touch no device; anything else that is not a Modbus call changes state
+    // (transport, cache, poll list) that later items may depend on.
+    const std::string method = req.at("method").as_string().c_str();
+    if (method == "ping" || method == "server.stats" || method == "transport.status" ||
+        method == "transport.serial_ports" || method == "cache.stats" || method == "poll.list" ||
+        method == "poll.values") {
+        return {};
+    }
+    if (method.rfind("modbus.", 0) != 0) {
+        return {BatchKey::Kind::Barrier};
+    }
+    if (!req.contains("params") || !req.at("params").is_object()) {
+        return {};
+    }
+
+    // Group calls may name several slaves; those are ordered against everything.
+    std::optional<std::int64_t> slave;
+    bool mixed = false;
+    auto note = [&](const json::object& obj) {
+        if (!obj.contains("slave_id") || !obj.at("slave_id").is_int64()) {
+            return;
+        }
+        const auto id = obj.at("slave_id").as_int64();
+        mixed = mixed || (slave && *slave != id);
+        slave = id;
+    };
+    const auto& params = req.at("params").as_object();
+    note(params);
+    if (params.contains("requests") && params.at("requests").is_array()) {
+        for (const auto& item : params.at("requests").as_array()) {
+            if (item.is_object()) {
+                note(item.as_object());
+            }
+        }
+    }
+    if (mixed) {
+        return {BatchKey::Kind::Barrier};
+    }
+    if (!slave) {
+        return {};
+    }
+    return {BatchKey::Kind::Slave, *slave};
+}
+
 } // namespace
 
-ApiController::ApiController(application::ApplicationCore& appCore)
-    : appCore_(appCore) {}
+ApiController::ApiController(application::ApplicationCore& appCore, const HttpJsonServer* server, TaskRunner runner)
+    : appCore_(appCore), server_(server), runner_(std::move(runner)) {}
 
 json::value ApiController::processRequest(const json::value& request) {
     if (request.is_array()) {
@@ -83,15 +261,101 @@ json::value ApiController::processRequest(const json::value& request) {
 }
 
 json::array ApiController::processBatch(const json::array& requests) {
-    json::array responses;
-    for (const auto& item : requests) {
-        if (!item.is_object()) {
-            responses.emplace_back(errorResponse(nullptr, -32600, "Batch item must be object"));
+    const bool ordered = std::any_of(requests.begin(), requests.end(), [](const json::value& item) {
+        return item.is_object() && item.as_object().contains("ordered") && item.as_object().at("ordered").is_bool() &&
+               item.as_object().at("ordered").as_bool();
+    });
+
+    std::vector<json::value> responses(requests.size());
+    std::vector<std::vector<std::size_t>> lanes;
+    std::map<std::int64_t, std::size_t> laneOfSlave;
+    auto flush = [&]() {
+        runLanes(requests, lanes, responses);
+        lanes.clear();
+        laneOfSlave.clear();
+    };
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        if (!requests[i].is_object()) {
+            responses[i] = errorResponse(nullptr, -32600, "Batch item must be object");
             continue;
         }
-        responses.emplace_back(processSingle(item.as_object()));
+
+        const auto key = ordered || !runner_ ? BatchKey{BatchKey::Kind::Barrier} : batchKeyOf(requests[i].as_object());
+        switch (key.kind) {
+            case BatchKey::Kind::Barrier:
+                flush();
+                lanes.push_back({i});
+                flush();
+                break;
+            case BatchKey::Kind::Slave: {
+                const auto [it, inserted] = laneOfSlave.emplace(key.slaveId, lanes.size());
+                if (inserted) {
+                    lanes.emplace_back();
+                }
+                lanes[it->second].push_back(i);
+                break;
+            }
+            case BatchKey::Kind::Free:
+                lanes.push_back({i});
+                break;
+        }
     }
-    return responses;
+    flush();
+
+    json::array result;
+    result.reserve(responses.size());
+    for (auto& response : responses) {
+        result.emplace_back(std::move(response));
+    }
+    return result;
+}
+
+void ApiController::runLanes(const json::array& requests, const std::vector<std::vector<std::size_t>>& lanes,
+                             std::vector<json::value>& responses) {
+    if (lanes.empty()) {
+        return;
+    }
+
+    // Lanes are offered to the runner, but the calling thread also works through them and runs
+    // every lane nobody has picked up yet. The batch therefore completes even when the runner's
+    // workers are all busy, including with this very call.
+    struct Run {
+        explicit Run(std::size_t count) : claimed(count), remaining(count) {}
+        std::vector<std::atomic<bool>> claimed;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t remaining;
+    };
+    auto run = std::make_shared<Run>(lanes.size());
+    auto runLane = [this, run, &requests, &lanes, &responses](std::size_t lane) {
+        if (run->claimed[lane].exchange(true)) {
+            return;
+        }
+        for (const auto index : lanes[lane]) {
+            responses[index] = processSingle(requests[index].as_object());
+        }
+        std::lock_guard<std::mutex> lock(run->mutex);
+        if (--run->remaining == 0) {
+            run->cv.notify_all();
+        }
+    };
+
+    if (runner_) {
+        for (std::size_t lane = 1; lane < lanes.size(); ++lane) {
+            runner_([run, runLane, lane]() {
+                if (!run->claimed[lane].load()) {
+                    runLane(lane);
+                }
+            });
+        }
+    }
+    for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+        runLane(lane);
+    }
+
+    std::unique_lock<std::mutex> lock(run->mutex);
+    run->cv.wait(lock, [&run]() { return run->remaining == 0; });
 }
 
 json::value ApiController::processSingle(const json::object& req) {
@@ -113,6 +377,36 @@ json::value ApiController::processSingle(const json::object& req) {
         return okResponse(id, result);
     }
 
+    if (method == "server.stats") {
+        if (!server_) {
+            return errorResponse(id, -32601, "server.stats is only available over HTTP");
+        }
+        const auto stats = server_->stats();
+        json::object result;
+        result["connections_accepted"] = stats.connectionsAccepted;
+        result["connections_active"] = stats.connectionsActive;
+        result["requests"] = stats.requests;
+        result["requests_active"] = stats.requestsActive;
+        result["keep_alive_reuses"] = stats.keepAliveReuses;
+        result["requests_per_second"] = stats.requestsPerSecond;
+        result["ws_sessions"] = stats.wsSessions;
+        result["ws_subscriptions"] = stats.wsSubscriptions;
+        result["ws_updates_sent"] = stats.wsUpdatesSent;
+        result["ws_samples_dropped"] = stats.wsSamplesDropped;
+
+        const auto engine = appCore_.subscriptions().stats();
+        json::object subscriptions;
+        subscriptions["subscriptions"] = engine.subscriptions;
+        subscriptions["registers"] = engine.registers;
+        subscriptions["samples"] = engine.samples;
+        subscriptions["registers_compared"] = engine.registersCompared;
+        subscriptions["reports"] = engine.reports;
+        subscriptions["registers_reported"] = engine.registersReported;
+        subscriptions["heartbeats"] = engine.heartbeats;
+        result["subscriptions"] = std::move(subscriptions);
+        return okResponse(id, result);
+    }
+
     if (method == "transport.serial_ports") {
         json::array ports;
         for (const auto& p : appCore_.listSerialPorts()) {
@@ -131,6 +425,60 @@ json::value ApiController::processSingle(const json::object& req) {
         result["serial_port"] = status.serialPort;
         result["baud_rate"] = status.baudRate;
         result["stop_bits"] = status.stopBits;
+
+        const auto rx = appCore_.receiveStats();
+        json::object receive;
+        receive["frames_decoded"] = rx.framesDecoded;
+        receive["bytes_received"] = rx.bytesReceived;
+        receive["overflow_bytes"] = rx.overflowBytes;
+        receive["decoders_created"] = rx.decodersCreated;
+        result["receive"] = receive;
+
+        json::array sessions;
+        for (const auto& stats : appCore_.sessionStats()) {
+            json::object session;
+            session["id"] = stats.sessionId;
+            session["type"] = stats.type == transport::ConnectionType::Tcp ? "tcp" : "rtu";
+            session["frames_written"] = stats.framesWritten;
+            session["write_calls"] = stats.writeCalls;
+            session["frames_per_write"] = stats.framesPerWrite();
+            session["bytes_written"] = stats.bytesWritten;
+            session["read_calls"] = stats.readCalls;
+            session["bytes_read"] = stats.bytesRead;
+            session["frame_allocations"] = stats.frameAllocations;
+            sessions.emplace_back(session);
+        }
+        result["sessions"] = sessions;
+
+        const auto planner = appCore_.readPlannerStats();
+        json::object readPlanner;
+        readPlanner["register_cost_us"] = planner.registerCostUs;
+        readPlanner["request_overhead_us"] = planner.requestOverheadUs;
+        readPlanner["max_gap"] = planner.maxGap;
+        result["read_planner"] = readPlanner;
+        result["reads_deduplicated"] = appCore_.readsDeduplicated();
+
+        const auto recovery = appCore_.recoveryStats();
+        json::object recoveryJson;
+        recoveryJson["drain_window_ms"] = appCore_.drainWindow().count();
+        recoveryJson["timeouts"] = recovery.timeouts;
+        recoveryJson["cancelled"] = recovery.cancelled;
+        recoveryJson["late_drained"] = recovery.lateDrained;
+        recoveryJson["drain_expired"] = recovery.drainExpired;
+        recoveryJson["unmatched"] = recovery.unmatched;
+        result["recovery"] = recoveryJson;
+
+        const auto sched = appCore_.schedulerStats();
+        json::object scheduler;
+        scheduler["workers"] = sched.workers;
+        scheduler["queued"] = sched.queued;
+        scheduler["max_queued"] = sched.maxQueued;
+        scheduler["running"] = sched.running;
+        scheduler["executed"] = sched.executed;
+        scheduler["failed"] = sched.failed;
+        scheduler["timers"] = sched.timers;
+        scheduler["overruns"] = sched.overruns;
+        result["scheduler"] = scheduler;
         return okResponse(id, result);
     }
 
@@ -169,6 +517,13 @@ json::value ApiController::processSingle(const json::object& req) {
             return errorResponse(id, -32602, "Unknown transport type");
         }
 
+        if (params.contains("connect_timeout_ms")) {
+            if (!params.at("connect_timeout_ms").is_int64() || params.at("connect_timeout_ms").as_int64() <= 0) {
+                return errorResponse(id, -32602, "connect_timeout_ms must be positive integer");
+            }
+            cfg.connectTimeoutMs = static_cast<std::uint32_t>(params.at("connect_timeout_ms").as_int64());
+        }
+
         std::string error;
         bool ok = false;
         json::object closed;
@@ -177,9 +532,9 @@ json::value ApiController::processSingle(const json::object& req) {
             ok = appCore_.switchTransport(cfg, error, closed);
         } else {
             if (cfg.type == transport::ConnectionType::Tcp) {
-                ok = appCore_.openTcpTransport(cfg.host, cfg.port, error);
+                ok = appCore_.openTcpTransport(cfg.host, cfg.port, error, cfg.connectTimeoutMs);
             } else {
-                ok = appCore_.openRtuTransport(cfg.serialPort, cfg.baudRate, cfg.stopBits, error);
+                ok = appCore_.openRtuTransport(cfg.serialPort, cfg.baudRate, cfg.stopBits, error, cfg.connectTimeoutMs);
             }
         }
 
@@ -204,25 +559,34 @@ json::value ApiController::processSingle(const json::object& req) {
         if (!parseUint8Strict(params, "slave_id", slaveId) || !parseAddressField(params, address) || !params.at("count").is_int64()) {
             return errorResponse(id, -32602, "Invalid slave_id/address/count format");
         }
+        const auto count = params.at("count").as_int64();
+        if (count < 1 || address + count > 0x10000) {
+            return errorResponse(id, -32602, "Invalid count");
+        }
 
         std::string error;
-        json::object readResult;
+        application::ReadResult readResult;
         const bool input = params.contains("input") && params.at("input").as_bool();
         const std::uint32_t timeoutMs = params.contains("timeout_ms") && params.at("timeout_ms").is_int64()
                                             ? static_cast<std::uint32_t>(params.at("timeout_ms").as_int64())
                                             : 2000U;
+        const std::uint32_t maxAgeMs = params.contains("max_age_ms") && params.at("max_age_ms").is_int64() &&
+                                               params.at("max_age_ms").as_int64() > 0
+                                           ? static_cast<std::uint32_t>(params.at("max_age_ms").as_int64())
+                                           : 0U;
         const bool ok = appCore_.readRegistersDetailed(
             slaveId,
             address,
-            static_cast<std::uint16_t>(params.at("count").as_int64()),
+            static_cast<std::uint16_t>(count),
             input,
             readResult,
             error,
-            timeoutMs);
+            timeoutMs,
+            maxAgeMs);
         if (!ok) {
             return errorResponse(id, -32002, error);
         }
-        return okResponse(id, readResult);
+        return okResponse(id, readResultToJson(readResult));
     }
 
     if (method == "modbus.read_group") {
@@ -241,7 +605,11 @@ json::value ApiController::processSingle(const json::object& req) {
                 !r.contains("count") || !r.at("count").is_int64()) {
                 return errorResponse(id, -32602, "Invalid group read item format");
             }
-            req.count = static_cast<std::uint16_t>(r.at("count").as_int64());
+            const auto count = r.at("count").as_int64();
+            if (count < 1 || req.startAddress + count > 0x10000) {
+                return errorResponse(id, -32602, "Invalid count");
+            }
+            req.count = static_cast<std::uint16_t>(count);
             req.function = r.contains("input") && r.at("input").as_bool()
                                ? protocol::FunctionCode::ReadInputRegisters
                                : protocol::FunctionCode::ReadHoldingRegisters;
@@ -249,17 +617,24 @@ json::value ApiController::processSingle(const json::object& req) {
         }
 
         std::string error;
-        json::array groupResults;
+        std::vector<application::ReadResult> groupResults;
         const std::uint32_t timeoutMs = params.contains("timeout_ms") && params.at("timeout_ms").is_int64()
                                             ? static_cast<std::uint32_t>(params.at("timeout_ms").as_int64())
                                             : 2000U;
-        if (!appCore_.readGroupDetailed(requests, groupResults, error, timeoutMs)) {
+        const bool coalesce = !params.contains("coalesce") || !params.at("coalesce").is_bool() || params.at("coalesce").as_bool();
+        if (!appCore_.readGroupDetailed(requests, groupResults, error, timeoutMs, coalesce)) {
             return errorResponse(id, -32002, error);
         }
+        json::array results;
+        results.reserve(groupResults.size());
+        for (const auto& single : groupResults) {
+            results.emplace_back(readResultToJson(single));
+        }
+
         json::object payload;
         payload["ok"] = true;
         payload["count"] = requests.size();
-        payload["results"] = groupResults;
+        payload["results"] = std::move(results);
         return okResponse(id, payload);
     }
 
@@ -331,37 +706,677 @@ json::value ApiController::processSingle(const json::object& req) {
             requests.push_back(req);
         }
 
+        const bool coalesce = !params.contains("coalesce") || !params.at("coalesce").is_bool() || params.at("coalesce").as_bool();
+        if (params.contains("dry_run") && params.at("dry_run").is_bool() && params.at("dry_run").as_bool()) {
+            json::array frames;
+            for (const auto& write : appCore_.planWriteGroup(requests, coalesce)) {
+                json::object frame;
+                frame["slave_id"] = write.request.slaveId;
+                frame["function"] = protocol::ProtocolHandler::functionToString(write.request.function);
+                frame["address"] = write.request.startAddress;
+                frame["count"] = write.request.values.size();
+                json::array items;
+                for (const auto index : write.items) {
+                    items.emplace_back(index);
+                }
+                frame["items"] = std::move(items);
+                frames.emplace_back(std::move(frame));
+            }
+            json::object payload;
+            payload["dry_run"] = true;
+            payload["count"] = requests.size();
+            payload["frame_count"] = frames.size();
+            payload["frames"] = std::move(frames);
+            return okResponse(id, payload);
+        }
+
         std::string error;
-        if (!appCore_.writeGroup(requests, error)) {
+        std::size_t framesSent = 0;
+        if (!appCore_.writeGroup(requests, error, coalesce, &framesSent)) {
             return errorResponse(id, -32003, error);
         }
-        return okResponse(id, json::object{{"accepted", true}, {"count", requests.size()}});
+        return okResponse(id, json::object{{"accepted", true}, {"count", requests.size()}, {"frames", framesSent}});
+    }
+
+    if (method == "modbus.changes_since") {
+        std::uint64_t cursor = 0;
+        std::size_t limit = kDefaultChangeLimit;
+        if (params.contains("cursor")) {
+            if (!params.at("cursor").is_int64() || params.at("cursor").as_int64() < 0) {
+                return errorResponse(id, -32602, "Invalid cursor");
+            }
+            cursor = static_cast<std::uint64_t>(params.at("cursor").as_int64());
+        }
+        if (params.contains("limit")) {
+            if (!params.at("limit").is_int64() || params.at("limit").as_int64() < 1 ||
+                params.at("limit").as_int64() > static_cast<std::int64_t>(kMaxChangeLimit)) {
+                return errorResponse(id, -32602, "limit must be 1.." + std::to_string(kMaxChangeLimit));
+            }
+            limit = static_cast<std::size_t>(params.at("limit").as_int64());
+        }
+
+        const auto set = appCore_.registerCache().changesSince(cursor, limit);
+        json::array changes;
+        changes.reserve(set.changes.size());
+        for (const auto& change : set.changes) {
+            json::object entry;
+            entry["slave_id"] = change.slaveId;
+            entry["input"] = change.table == protocol::FunctionCode::ReadInputRegisters;
+            entry["address"] = change.address;
+            entry["value"] = change.value;
+            changes.emplace_back(std::move(entry));
+        }
+
+        json::object result;
+        result["cursor"] = set.cursor;
+        result["reset"] = set.reset;
+        result["more"] = set.more;
+        result["changes"] = std::move(changes);
+        return okResponse(id, result);
+    }
+
+    if (method == "cache.stats") {
+        auto& cache = appCore_.registerCache();
+        json::array devices;
+        for (const auto& stats : cache.stats()) {
+            json::object device;
+            device["slave_id"] = stats.slaveId;
+            device["hits"] = stats.hits;
+            device["misses"] = stats.misses;
+            device["registers_from_cache"] = stats.registersFromCache;
+            device["registers_fetched"] = stats.registersFetched;
+            devices.emplace_back(std::move(device));
+        }
+
+        json::object result;
+        result["pages"] = cache.pageCount();
+        result["page_size"] = application::RegisterCache::kPageSize;
+        result["ttl_ms"] = cache.ttl().count();
+        result["change_sequence"] = cache.changeSequence();
+        result["change_log_size"] = cache.changeLogSize();
+        result["change_log_capacity"] = cache.changeLogCapacity();
+        result["devices"] = std::move(devices);
+        return okResponse(id, result);
+    }
+
+    if (method == "cache.clear") {
+        appCore_.registerCache().clear();
+        return okResponse(id, json::object{{"cleared", true}});
+    }
+
+    if (method == "poll.add") {
+        std::vector<application::PollItemConfig> configs;
+        if (params.contains("items")) {
+            if (!params.at("items").is_array()) {
+                return errorResponse(id, -32602, "items must be array");
+            }
+            for (const auto& item : params.at("items").as_array()) {
+                application::PollItemConfig config;
+                if (!item.is_object() || !parsePollItem(item.as_object(), config)) {
+                    return errorResponse(id, -32602, "Invalid poll item format");
+                }
+                configs.push_back(config);
+            }
+        } else {
+            application::PollItemConfig config;
+            if (!parsePollItem(params, config)) {
+                return errorResponse(id, -32602, "slave_id, address, count, period_ms are required");
+            }
+            configs.push_back(config);
+        }
+
+        json::array ids;
+        for (const auto& config : configs) {
+            std::uint64_t itemId = 0;
+            std::string error;
+            if (!appCore_.polling().add(config, itemId, error)) {
+                for (const auto& added : ids) {
+                    appCore_.polling().remove(added.as_uint64());
+                }
+                return errorResponse(id, -32602, error);
+            }
+            ids.emplace_back(itemId);
+        }
+        return okResponse(id, json::object{{"ids", ids}});
+    }
+
+    if (method == "poll.remove") {
+        std::size_t removed = 0;
+        if (params.contains("all") && params.at("all").is_bool() && params.at("all").as_bool()) {
+            removed = appCore_.polling().items().size();
+            appCore_.polling().clear();
+        } else if (params.contains("ids") && params.at("ids").is_array()) {
+            for (const auto& v : params.at("ids").as_array()) {
+                if (v.is_int64() && v.as_int64() > 0 && appCore_.polling().remove(static_cast<std::uint64_t>(v.as_int64()))) {
+                    ++removed;
+                }
+            }
+        } else if (params.contains("id") && params.at("id").is_int64() && params.at("id").as_int64() > 0) {
+            removed = appCore_.polling().remove(static_cast<std::uint64_t>(params.at("id").as_int64())) ? 1 : 0;
+        } else {
+            return errorResponse(id, -32602, "id, ids or all is required");
+        }
+        return okResponse(id, json::object{{"removed", removed}});
+    }
+
+    if (method == "poll.list") {
+        json::array items;
+        for (const auto& item : appCore_.polling().items()) {
+            items.emplace_back(pollItemToJson(item));
+        }
+
+        const auto stats = appCore_.polling().stats();
+        json::object engine;
+        engine["items"] = stats.items;
+        engine["cycles"] = stats.cycles;
+        engine["requests"] = stats.requests;
+        engine["registers_wanted"] = stats.registersWanted;
+        engine["registers_read"] = stats.registersRead;
+        engine["busy_ratio"] = stats.busyRatio;
+
+        json::object result;
+        result["items"] = std::move(items);
+        result["engine"] = std::move(engine);
+        return okResponse(id, result);
+    }
+
+    if (method == "poll.values") {
+        json::array values;
+        if (params.contains("ids") && params.at("ids").is_array()) {
+            for (const auto& v : params.at("ids").as_array()) {
+                if (!v.is_int64() || v.as_int64() <= 0) {
+                    return errorResponse(id, -32602, "ids must be positive int array");
+                }
+                const auto item = appCore_.polling().item(static_cast<std::uint64_t>(v.as_int64()));
+                if (!item) {
+                    return errorResponse(id, -32004, "Unknown poll item " + std::to_string(v.as_int64()));
+                }
+                values.emplace_back(pollValueToJson(*item));
+            }
+        } else {
+            for (const auto& item : appCore_.polling().items()) {
+                values.emplace_back(pollValueToJson(item));
+            }
+        }
+        return okResponse(id, json::object{{"values", values}});
     }
 
     return errorResponse(id, -32601, "Method not found");
 }
 
 json::value ApiController::errorResponse(const json::value& id, int code, const std::string& message) const {
-    json::object r;
-    r["jsonrpc"] = "2.0";
-    r["id"] = id;
-    json::object e;
-    e["code"] = code;
-    e["message"] = message;
-    r["error"] = e;
-    return r;
+    return rpcError(id, code, message);
 }
 
 json::value ApiController::okResponse(const json::value& id, const json::value& result) const {
-    json::object r;
-    r["jsonrpc"] = "2.0";
-    r["id"] = id;
-    r["result"] = result;
-    return r;
+    return rpcResult(id, result);
 }
 
-HttpJsonServer::HttpJsonServer(application::ApplicationCore& appCore, std::string bindAddress, std::uint16_t port)
-    : appCore_(appCore), bindAddress_(std::move(bindAddress)), port_(port) {}
+// One WebSocket connection: JSON-RPC calls as text messages plus register subscriptions served by
+// the subscription engine. Reported changes are merged into each subscription's snapshot and only
+// one message is written at a time, so a client that reads slowly gets the newest value of every
+// changed register and skips the values in between (counted as dropped).
+class HttpJsonServer::WsSession : public std::enable_shared_from_this<WsSession> {
+public:
+    WsSession(HttpJsonServer& server, beast::tcp_stream stream) : server_(server), ws_(std::move(stream)) {
+        ++server_.wsSessionsActive_;
+    }
+
+    ~WsSession() {
+        server_.removeConnection(connectionId_);
+        release();
+        --server_.wsSessionsActive_;
+    }
+
+    void start(Request request) {
+        connectionId_ = server_.addConnection([weak = weak_from_this()]() {
+            if (auto self = weak.lock()) {
+                runOn(self->ws_.get_executor(), [&self]() { self->abort(); });
+            }
+        });
+        upgrade_ = std::move(request);
+        ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+        ws_.read_message_max(kMaxMessageBytes);
+        ws_.async_accept(upgrade_, [self = shared_from_this()](beast::error_code ec) {
+            if (!ec) {
+                self->read();
+            }
+        });
+    }
+
+    // Called from the engine's sink; only touches the snapshots and schedules a flush.
+    void offer(const application::ChangeReport& report) {
+        bool flush = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = subscriptions_.find(report.subscriptionId);
+            if (it == subscriptions_.end()) {
+                return;
+            }
+            auto& subscription = it->second;
+            for (const auto& change : report.changes) {
+                const auto index = static_cast<std::size_t>(change.address - subscription.address);
+                if (subscription.pending[index]) {
+                    ++subscription.dropped;
+                    ++server_.wsSamplesDropped_;
+                }
+                subscription.values[index] = change.value;
+                subscription.pending[index] = true;
+            }
+            subscription.heartbeat = subscription.heartbeat || report.heartbeat;
+            subscription.timestamp = report.timestamp;
+            subscription.dirty = true;
+            flush = !flushPosted_;
+            flushPosted_ = true;
+        }
+        if (flush) {
+            boost::asio::post(ws_.get_executor(), [self = shared_from_this()]() {
+                {
+                    std::lock_guard<std::mutex> lock(self->mutex_);
+                    self->flushPosted_ = false;
+                }
+                self->pump();
+            });
+        }
+    }
+
+    static constexpr std::chrono::milliseconds kDefaultMinInterval{100};
+    static constexpr std::size_t kMaxSubscriptions = 256;
+    static constexpr std::size_t kMaxMessageBytes = 1024 * 1024;
+
+private:
+    struct Subscription {
+        std::uint8_t slaveId = 0;
+        bool input = false;
+        std::uint16_t address = 0;
+        std::uint64_t pollId = 0;  // poll item added on the client's behalf, removed with the subscription
+        std::vector<std::uint16_t> values;
+        std::vector<bool> pending;  // changed since the last send
+        bool dirty = false;
+        bool heartbeat = false;
+        std::uint64_t dropped = 0;  // values overwritten since the last send
+        std::chrono::system_clock::time_point timestamp;
+    };
+
+    void read() {
+        ws_.async_read(buffer_, [self = shared_from_this()](beast::error_code ec, std::size_t) { self->onMessage(ec); });
+    }
+
+    void onMessage(beast::error_code ec) {
+        if (ec) {
+            abort();
+            release();
+            return;
+        }
+
+        const auto text = beast::buffers_to_string(buffer_.data());
+        buffer_.consume(buffer_.size());
+        read();
+
+        json::value payload;
+        try {
+            payload = json::parse(text);
+        } catch (const std::exception&) {
+            queue(json::serialize(rpcError(nullptr, -32700, "Parse error: invalid JSON")));
+            return;
+        }
+
+        if (payload.is_object() && payload.as_object().contains("method") && payload.as_object().at("method").is_string()) {
+            const std::string method = payload.as_object().at("method").as_string().c_str();
+            if (method == "subscribe" || method == "unsubscribe") {
+                queue(json::serialize(handleSubscription(method, payload.as_object())));
+                return;
+            }
+        }
+
+        // Anything else is an ordinary JSON-RPC call or batch and may wait on the bus.
+        ++server_.requestsActive_;
+        boost::asio::post(server_.workers_, [self = shared_from_this(), payload = std::move(payload)]() {
+            auto reply = std::make_shared<std::string>(json::serialize(self->server_.controller().processRequest(payload)));
+            boost::asio::post(self->ws_.get_executor(), [self, reply]() {
+                --self->server_.requestsActive_;
+                self->server_.countRequest();
+                self->queue(std::move(*reply));
+            });
+        });
+    }
+
+    json::value handleSubscription(const std::string& method, const json::object& req) {
+        const json::value id = req.contains("id") ? req.at("id") : json::value(nullptr);
+        if (!req.contains("params") || !req.at("params").is_object()) {
+            return rpcError(id, -32602, "params object is required");
+        }
+        const auto& params = req.at("params").as_object();
+
+        if (method == "unsubscribe") {
+            if (!params.contains("subscription") || !params.at("subscription").is_int64()) {
+                return rpcError(id, -32602, "subscription is required");
+            }
+            const auto subscriptionId = static_cast<std::uint64_t>(params.at("subscription").as_int64());
+            std::optional<Subscription> removed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const auto it = subscriptions_.find(subscriptionId);
+                if (it != subscriptions_.end()) {
+                    removed = std::move(it->second);
+                    subscriptions_.erase(it);
+                }
+            }
+            if (removed) {
+                drop(subscriptionId, *removed);
+            }
+            return rpcResult(id, json::object{{"removed", removed.has_value()}});
+        }
+
+        application::SubscriptionConfig config;
+        if (!parseUint8Strict(params, "slave_id", config.slaveId) || !parseAddressField(params, config.address) ||
+            !params.contains("count") || !params.at("count").is_int64()) {
+            return rpcError(id, -32602, "slave_id, address, count are required");
+        }
+        const auto count = params.at("count").as_int64();
+        if (count < 1 || config.address + count > 0x10000) {
+            return rpcError(id, -32602, "Invalid count");
+        }
+        config.count = static_cast<std::uint16_t>(count);
+        const bool input = params.contains("input") && params.at("input").is_bool() && params.at("input").as_bool();
+        config.function = input ? protocol::FunctionCode::ReadInputRegisters : protocol::FunctionCode::ReadHoldingRegisters;
+
+        auto milliseconds = [&params](const char* key, std::chrono::milliseconds fallback) -> std::optional<std::chrono::milliseconds> {
+            if (!params.contains(key)) {
+                return fallback;
+            }
+            if (!params.at(key).is_int64() || params.at(key).as_int64() < 0) {
+                return std::nullopt;
+            }
+            return std::chrono::milliseconds(params.at(key).as_int64());
+        };
+        const auto minInterval = milliseconds("min_interval_ms", kDefaultMinInterval);
+        const auto maxInterval = milliseconds("max_interval_ms", std::chrono::milliseconds(0));
+        const auto period = milliseconds("period_ms", std::chrono::milliseconds(0));
+        if (!minInterval || !maxInterval || !period) {
+            return rpcError(id, -32602, "Invalid min_interval_ms/max_interval_ms/period_ms");
+        }
+        config.minInterval = *minInterval;
+        config.maxInterval = *maxInterval;
+
+        if (params.contains("deadband") && params.contains("deadband_percent")) {
+            return rpcError(id, -32602, "deadband and deadband_percent are mutually exclusive");
+        }
+        for (const char* key : {"deadband", "deadband_percent"}) {
+            if (!params.contains(key)) {
+                continue;
+            }
+            if (!params.at(key).is_number()) {
+                return rpcError(id, -32602, std::string("Invalid ") + key);
+            }
+            config.deadband = params.at(key).to_number<double>();
+            config.deadbandMode = std::string(key) == "deadband" ? application::DeadbandMode::Absolute
+                                                                 : application::DeadbandMode::Percent;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (subscriptions_.size() >= kMaxSubscriptions) {
+                return rpcError(id, -32602, "Too many subscriptions on this connection");
+            }
+        }
+
+        Subscription subscription;
+        subscription.slaveId = config.slaveId;
+        subscription.input = input;
+        subscription.address = config.address;
+        subscription.values.assign(config.count, 0);
+        subscription.pending.assign(config.count, false);
+
+        // With period_ms the range is also put on the scan list, for as long as the subscription lives.
+        std::string error;
+        if (period->count() > 0) {
+            application::PollItemConfig pollConfig;
+            pollConfig.slaveId = config.slaveId;
+            pollConfig.function = config.function;
+            pollConfig.address = config.address;
+            pollConfig.count = config.count;
+            pollConfig.period = *period;
+            if (!server_.appCore_.polling().add(pollConfig, subscription.pollId, error)) {
+                return rpcError(id, -32602, error);
+            }
+        }
+
+        // Registered before the engine can report on it, so no early report is lost.
+        std::uint64_t subscriptionId = 0;
+        std::lock_guard<std::mutex> routes(server_.wsMutex_);
+        if (!server_.appCore_.subscriptions().add(config, subscriptionId, error)) {
+            if (subscription.pollId != 0) {
+                server_.appCore_.polling().remove(subscription.pollId);
+            }
+            return rpcError(id, -32602, error);
+        }
+        server_.wsRoutes_[subscriptionId] = weak_from_this();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            subscriptions_.emplace(subscriptionId, std::move(subscription));
+        }
+        ++server_.wsSubscriptions_;
+        return rpcResult(id, json::object{{"subscription", subscriptionId}});
+    }
+
+    // Ends every subscription once the connection is done.
+    void release() {
+        std::map<std::uint64_t, Subscription> subscriptions;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            subscriptions.swap(subscriptions_);
+        }
+        for (const auto& [subscriptionId, subscription] : subscriptions) {
+            drop(subscriptionId, subscription);
+        }
+    }
+
+    void drop(std::uint64_t subscriptionId, const Subscription& subscription) {
+        server_.appCore_.subscriptions().remove(subscriptionId);
+        if (subscription.pollId != 0) {
+            server_.appCore_.polling().remove(subscription.pollId);
+        }
+        {
+            std::lock_guard<std::mutex> lock(server_.wsMutex_);
+            server_.wsRoutes_.erase(subscriptionId);
+        }
+        --server_.wsSubscriptions_;
+    }
+
+    // Drops the connection on the strand: closing the socket cancels the pending read and write and
+    // the stream's timer, so nothing keeps the session alive afterwards.
+    void abort() {
+        closed_ = true;
+        beast::get_lowest_layer(ws_).close();
+    }
+
+    void queue(std::string message) {
+        replies_.push_back(std::move(message));
+        pump();
+    }
+
+    // Writes the next reply, or else the changes collected since the last send; runs on the strand.
+    void pump() {
+        if (writing_ || closed_) {
+            return;
+        }
+
+        std::string message;
+        if (!replies_.empty()) {
+            message = std::move(replies_.front());
+            replies_.pop_front();
+        } else {
+            message = takeUpdates();
+        }
+        if (message.empty()) {
+            return;
+        }
+
+        writing_ = true;
+        auto buffer = std::make_shared<std::string>(std::move(message));
+        ws_.text(true);
+        ws_.async_write(boost::asio::buffer(*buffer), [self = shared_from_this(), buffer](beast::error_code ec, std::size_t) {
+            self->writing_ = false;
+            if (ec) {
+                self->abort();  // the pending read fails as well and ends the session
+                return;
+            }
+            self->pump();
+        });
+    }
+
+    std::string takeUpdates() {
+        json::array updates;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& [subscriptionId, subscription] : subscriptions_) {
+                if (!subscription.dirty) {
+                    continue;
+                }
+
+                json::array changes;
+                for (std::size_t i = 0; i < subscription.values.size(); ++i) {
+                    if (subscription.pending[i]) {
+                        changes.emplace_back(json::object{{"address", subscription.address + i}, {"value", subscription.values[i]}});
+                        subscription.pending[i] = false;
+                    }
+                }
+                json::object update;
+                update["subscription"] = subscriptionId;
+                update["slave_id"] = subscription.slaveId;
+                update["input"] = subscription.input;
+                update["changes"] = std::move(changes);
+                update["heartbeat"] = subscription.heartbeat;
+                update["dropped"] = subscription.dropped;
+                update["timestamp_ms"] = toUnixMs(subscription.timestamp);
+                updates.emplace_back(std::move(update));
+
+                subscription.dirty = false;
+                subscription.heartbeat = false;
+                subscription.dropped = 0;
+            }
+        }
+        if (updates.empty()) {
+            return {};
+        }
+
+        server_.wsUpdatesSent_ += updates.size();
+        json::object notification;
+        notification["jsonrpc"] = "2.0";
+        notification["method"] = "values";
+        notification["params"] = json::object{{"updates", std::move(updates)}};
+        return json::serialize(notification);
+    }
+
+    HttpJsonServer& server_;
+    websocket::stream<beast::tcp_stream> ws_;
+    beast::flat_buffer buffer_;
+    Request upgrade_;
+
+    std::uint64_t connectionId_ = 0;
+
+    // Strand only.
+    std::deque<std::string> replies_;
+    bool writing_ = false;
+    bool closed_ = false;
+
+    // Shared with offer(), which runs wherever the engine reports.
+    std::mutex mutex_;
+    std::map<std::uint64_t, Subscription> subscriptions_;  // keyed by engine subscription ID
+    bool flushPosted_ = false;
+};
+
+class HttpJsonServer::Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(HttpJsonServer& server, tcp::socket socket) : server_(server), stream_(std::move(socket)) {
+        ++server_.connectionsActive_;
+    }
+
+    ~Session() {
+        server_.removeConnection(connectionId_);
+        --server_.connectionsActive_;
+    }
+
+    void start() {
+        connectionId_ = server_.addConnection([weak = weak_from_this(), executor = stream_.get_executor()]() {
+            if (auto self = weak.lock()) {
+                runOn(executor, [&self]() {
+                    if (self->connectionId_ != 0) {  // zero once the stream has moved to a WsSession
+                        self->stream_.close();
+                    }
+                });
+            }
+        });
+        boost::asio::dispatch(stream_.get_executor(), [self = shared_from_this()]() { self->read(); });
+    }
+
+private:
+    void read() {
+        request_ = {};
+        stream_.expires_after(server_.options_.idleTimeout);
+        http::async_read(stream_, buffer_, request_, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            self->onRead(ec);
+        });
+    }
+
+    void onRead(beast::error_code ec) {
+        if (ec) {
+            close();  // peer closed, idle timeout or malformed request
+            return;
+        }
+
+        stream_.expires_never();
+        if (websocket::is_upgrade(request_)) {
+            server_.removeConnection(connectionId_);
+            connectionId_ = 0;
+            std::make_shared<WsSession>(server_, std::move(stream_))->start(std::move(request_));
+            return;
+        }
+        if (served_++ > 0) {
+            ++server_.keepAliveReuses_;
+        }
+        ++server_.requestsActive_;
+        boost::asio::post(server_.workers_, [self = shared_from_this()]() {
+            auto response = std::make_shared<Response>(self->server_.buildResponse(self->request_));
+            boost::asio::post(self->stream_.get_executor(), [self, response]() { self->write(response); });
+        });
+    }
+
+    void write(const std::shared_ptr<Response>& response) {
+        --server_.requestsActive_;
+        server_.countRequest();
+
+        stream_.expires_after(server_.options_.idleTimeout);
+        http::async_write(stream_, *response, [self = shared_from_this(), response](beast::error_code ec, std::size_t) {
+            if (ec || !response->keep_alive()) {
+                self->close();
+                return;
+            }
+            self->read();
+        });
+    }
+
+    void close() {
+        beast::error_code ec;
+        stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+    }
+
+    HttpJsonServer& server_;
+    beast::tcp_stream stream_;
+    beast::flat_buffer buffer_;
+    Request request_;
+    std::uint64_t served_ = 0;
+    std::uint64_t connectionId_ = 0;
+};
+
+HttpJsonServer::HttpJsonServer(application::ApplicationCore& appCore, std::string bindAddress, std::uint16_t port,
+                               HttpServerOptions options)
+    : appCore_(appCore),
+      bindAddress_(std::move(bindAddress)),
+      port_(port),
+      options_(options),
+      workers_(std::max<std::size_t>(options.workerThreads, 1)) {}
 
 HttpJsonServer::~HttpJsonServer() {
     stop();
@@ -373,9 +1388,14 @@ void HttpJsonServer::start() {
     }
 
     running_ = true;
+    sinkId_ = appCore_.subscriptions().addSink([this](const application::ChangeReport& report) { route(report); });
     acceptor_ = std::make_unique<tcp::acceptor>(ioContext_, tcp::endpoint{boost::asio::ip::make_address(bindAddress_), port_});
+    doAccept();
 
-    serverThread_ = std::thread([this]() { acceptLoop(); });
+    const auto threads = std::max<std::size_t>(options_.ioThreads, 1);
+    for (std::size_t i = 0; i < threads; ++i) {
+        ioThreads_.emplace_back([this]() { ioContext_.run(); });
+    }
 }
 
 void HttpJsonServer::stop() {
@@ -384,66 +1404,139 @@ void HttpJsonServer::stop() {
     }
 
     running_ = false;
-    boost::system::error_code ec;
-    if (acceptor_) {
-        acceptor_->cancel(ec);
+    appCore_.subscriptions().removeSink(sinkId_);
+
+    // Refuse new connections and drop the open ones while the io threads still run their handlers.
+    runOn(ioContext_.get_executor(), [this]() {
+        boost::system::error_code ec;
         acceptor_->close(ec);
+    });
+    std::vector<std::function<void()>> aborts;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        for (const auto& [_, abort] : connections_) {
+            aborts.push_back(abort);
+        }
+    }
+    for (const auto& abort : aborts) {
+        abort();
     }
-    ioContext_.stop();
 
-    if (serverThread_.joinable()) {
-        serverThread_.join();
+    ioContext_.stop();
+    for (auto& thread : ioThreads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
     }
+    ioThreads_.clear();
+
+    // Let calls already on a worker finish their Modbus exchange; their responses are dropped.
+    workers_.join();
 }
 
-void HttpJsonServer::acceptLoop() {
-    while (running_) {
-        boost::system::error_code ec;
-        tcp::socket socket(ioContext_);
-        acceptor_->accept(socket, ec);
-        if (ec) {
-            continue;
+HttpServerStats HttpJsonServer::stats() const {
+    HttpServerStats stats;
+    stats.connectionsAccepted = connectionsAccepted_.load();
+    stats.connectionsActive = connectionsActive_.load();
+    stats.requests = requests_.load();
+    stats.requestsActive = requestsActive_.load();
+    stats.keepAliveReuses = keepAliveReuses_.load();
+    stats.wsSessions = wsSessionsActive_.load();
+    stats.wsSubscriptions = wsSubscriptions_.load();
+    stats.wsUpdatesSent = wsUpdatesSent_.load();
+    stats.wsSamplesDropped = wsSamplesDropped_.load();
+
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::uint64_t recent = 0;
+    std::lock_guard<std::mutex> lock(rateMutex_);
+    for (const auto& [second, count] : rateBuckets_) {
+        if (second > now - static_cast<std::int64_t>(kRateWindow) && second < now) {
+            recent += count;
         }
-        handleSession(std::move(socket));
     }
+    // The current second is still filling up, so the rate covers the complete seconds before it.
+    stats.requestsPerSecond = static_cast<double>(recent) / static_cast<double>(kRateWindow - 1);
+    return stats;
 }
 
-void HttpJsonServer::handleSession(tcp::socket socket) {
-    beast::flat_buffer buffer;
-    http::request<http::string_body> req;
-    boost::system::error_code ec;
+void HttpJsonServer::doAccept() {
+    acceptor_->async_accept(boost::asio::make_strand(ioContext_), [this](beast::error_code ec, tcp::socket socket) {
+        if (!running_ || ec == boost::asio::error::operation_aborted) {
+            return;
+        }
+        if (!ec) {
+            ++connectionsAccepted_;
+            std::make_shared<Session>(*this, std::move(socket))->start();
+        }
+        doAccept();
+    });
+}
 
-    http::read(socket, buffer, req, ec);
-    if (ec) {
-        return;
+std::uint64_t HttpJsonServer::addConnection(std::function<void()> abort) {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    const auto id = ++nextConnectionId_;
+    connections_.emplace(id, std::move(abort));
+    return id;
+}
+
+void HttpJsonServer::removeConnection(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    connections_.erase(id);
+}
+
+void HttpJsonServer::countRequest() {
+    ++requests_;
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lock(rateMutex_);
+    auto& bucket = rateBuckets_[static_cast<std::size_t>(now) % kRateWindow];
+    if (bucket.first != now) {
+        bucket = {now, 0};
+    }
+    ++bucket.second;
+}
+
+void HttpJsonServer::route(const application::ChangeReport& report) {
+    std::shared_ptr<WsSession> session;
+    {
+        std::lock_guard<std::mutex> lock(wsMutex_);
+        const auto it = wsRoutes_.find(report.subscriptionId);
+        if (it != wsRoutes_.end()) {
+            session = it->second.lock();
+        }
+    }
+    if (session) {
+        session->offer(report);
     }
+}
+
+ApiController HttpJsonServer::controller() const {
+    return ApiController(appCore_, this, [this](ApiController::Task task) { boost::asio::post(workers_, std::move(task)); });
+}
 
-    http::response<http::string_body> res;
+HttpJsonServer::Response HttpJsonServer::buildResponse(const Request& req) const {
+    Response res;
     res.version(req.version());
-    res.keep_alive(false);
+    res.keep_alive(req.keep_alive());
     res.set(http::field::content_type, "application/json");
-    
+
     res.set(http::field::access_control_allow_origin, "*");
     res.set(http::field::access_control_allow_methods, "POST, OPTIONS, GET");
     res.set(http::field::access_control_allow_headers, "Content-Type, Accept");
     res.set(http::field::access_control_max_age, "86400");
-    
+
     if (req.method() == http::verb::options) {
         res.result(http::status::no_content);  // 204 No Content
-        res.body().clear();
         res.prepare_payload();
-        http::write(socket, res, ec);
-        return;
+        return res;
     }
-    
+
     if (req.method() != http::verb::post) {
         res.result(http::status::method_not_allowed);
         res.body() = R"({"jsonrpc":"2.0","id":null,"error":{"code":-32600,"message":"Only POST method is supported"}})";
         res.prepare_payload();
-        http::write(socket, res, ec);
-        return;
+        return res;
     }
-    
+
     json::value payload;
     try {
         payload = json::parse(req.body());
@@ -452,20 +1545,15 @@ void HttpJsonServer::handleSession(tcp::socket socket) {
         // 🔥 Ошибка парсинга в формате JSON-RPC 2.0
         res.body() = R"({"jsonrpc":"2.0","id":null,"error":{"code":-32700,"message":"Parse error: invalid JSON"}})";
         res.prepare_payload();
-        http::write(socket, res, ec);
-        return;
+        return res;
     }
-    
-    ApiController controller(appCore_);
-    const auto response = controller.processRequest(payload);
-    
+
+    const auto response = controller().processRequest(payload);
+
     res.result(http::status::ok);
     res.body() = json::serialize(response);  // boost::json → string
     res.prepare_payload();
-    
-    http::write(socket, res, ec);
-    
-    socket.shutdown(tcp::socket::shutdown_both, ec);
+    return res;
 }
 
 } // namespace api
@@ -5,52 +5,140 @@
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "layers/application/application_layer.h"
 
 namespace api {
 
+class HttpJsonServer;
+
 class ApiController {
 public:
-    explicit ApiController(application::ApplicationCore& appCore);
+    using Task = std::function<void()>;
+    using TaskRunner = std::function<void(Task)>;
+
+    // `server` (optional) answers `server.stats`; with a `runner`, batch items for different
+    // devices run concurrently on it.
+    explicit ApiController(application::ApplicationCore& appCore, const HttpJsonServer* server = nullptr,
+                           TaskRunner runner = {});
 
     boost::json::value processRequest(const boost::json::value& request);
+    // Responses always come back in request order. Items for the same slave keep their relative
+    // order, calls that change server state (transport, cache.clear, poll.add/remove) or address
+    // several slaves run alone after everything before them, and a batch in which any item carries
+    // "ordered": true runs strictly one item at a time.
     boost::json::array processBatch(const boost::json::array& requests);
 
 private:
+    void runLanes(const boost::json::array& requests, const std::vector<std::vector<std::size_t>>& lanes,
+                  std::vector<boost::json::value>& responses);
+
     boost::json::value processSingle(const boost::json::object& req);
     boost::json::value errorResponse(const boost::json::value& id, int code, const std::string& message) const;
     boost::json::value okResponse(const boost::json::value& id, const boost::json::value& result) const;
 
     application::ApplicationCore& appCore_;
+    const HttpJsonServer* server_;
+    TaskRunner runner_;
 };
 
+struct HttpServerOptions {
+    std::size_t ioThreads = 1;
+    // Handlers block on Modbus round trips, so this bounds how many JSON-RPC calls run at once.
+    std::size_t workerThreads = 8;
+    std::chrono::seconds idleTimeout{30};  // keep-alive connections with no request for this long are closed
+};
+
+struct HttpServerStats {
+    std::uint64_t connectionsAccepted = 0;
+    std::uint64_t connectionsActive = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t requestsActive = 0;    // handed to a worker, response not yet written
+    std::uint64_t keepAliveReuses = 0;   // requests that arrived on an already used connection
+    double requestsPerSecond = 0.0;      // over the last kRateWindow seconds
+
+    std::uint64_t wsSessions = 0;
+    std::uint64_t wsSubscriptions = 0;
+    std::uint64_t wsUpdatesSent = 0;     // value notifications pushed to clients
+    std::uint64_t wsSamplesDropped = 0;  // samples replaced by a newer one before they could be sent
+};
+
+// HTTP/1.1 JSON-RPC endpoint. Connections are served asynchronously on the io threads with
+// keep-alive; each request is parsed there and handed to the worker pool, and the response is
+// written back on the connection's strand. A connection that asks for a WebSocket upgrade takes the
+// same JSON-RPC calls as messages and can subscribe to register ranges, whose values are then pushed
+// as they come off the wire.
 class HttpJsonServer {
 public:
-    HttpJsonServer(application::ApplicationCore& appCore, std::string bindAddress, std::uint16_t port);
+    HttpJsonServer(application::ApplicationCore& appCore, std::string bindAddress, std::uint16_t port,
+                   HttpServerOptions options = {});
     ~HttpJsonServer();
 
     void start();
     void stop();
 
+    HttpServerStats stats() const;
+
+    static constexpr std::size_t kRateWindow = 10;
+
 private:
-    void acceptLoop();
-    void handleSession(boost::asio::ip::tcp::socket socket);
+    class Session;
+    class WsSession;
+    using Request = boost::beast::http::request<boost::beast::http::string_body>;
+    using Response = boost::beast::http::response<boost::beast::http::string_body>;
+
+    void doAccept();
+    ApiController controller() const;
+    Response buildResponse(const Request& req) const;
+    void countRequest();
+    void route(const application::ChangeReport& report);
+    // Open connections register a callback that drops them, so stop() can close every one of them
+    // before the io threads go away.
+    std::uint64_t addConnection(std::function<void()> abort);
+    void removeConnection(std::uint64_t id);
 
     application::ApplicationCore& appCore_;
     std::string bindAddress_;
     std::uint16_t port_;
+    HttpServerOptions options_;
+
+    // Declared before the io_context: sessions it still owns on destruction update them.
+    std::atomic<std::uint64_t> connectionsAccepted_{0};
+    std::atomic<std::uint64_t> connectionsActive_{0};
+    std::atomic<std::uint64_t> requests_{0};
+    std::atomic<std::uint64_t> requestsActive_{0};
+    std::atomic<std::uint64_t> keepAliveReuses_{0};
+    std::atomic<std::uint64_t> wsSessionsActive_{0};
+    std::atomic<std::uint64_t> wsSubscriptions_{0};
+    std::atomic<std::uint64_t> wsUpdatesSent_{0};
+    std::atomic<std::uint64_t> wsSamplesDropped_{0};
+    mutable std::mutex rateMutex_;
+    std::array<std::pair<std::int64_t, std::uint64_t>, kRateWindow> rateBuckets_{};  // (second, requests)
+
+    application::SubscriptionEngine::SinkId sinkId_ = 0;
+    std::mutex wsMutex_;
+    std::unordered_map<std::uint64_t, std::weak_ptr<WsSession>> wsRoutes_;  // engine subscription -> its connection
+    std::mutex connectionsMutex_;
+    std::uint64_t nextConnectionId_ = 0;
+    std::unordered_map<std::uint64_t, std::function<void()>> connections_;
 
     boost::asio::io_context ioContext_;
     std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
     std::atomic<bool> running_{false};
-    std::thread serverThread_;
+    std::vector<std::thread> ioThreads_;
+    mutable boost::asio::thread_pool workers_;  // also runs independent batch lanes from handlers
 };
 
 } // namespace api
@@ -0,0 +1,87 @@
+#pragma once
+
+// Awaitable front end of the ApplicationCore async API. Part of the optional C++20 build
+// (-DMODBUSCONFIG_COROUTINES=ON); the rest of the application layer stays C++17.
+//
+//     boost::asio::co_spawn(core.scheduler().executor(), [&core]() -> boost::asio::awaitable<void> {
+//         auto setpoint = co_await application::co_read(core, request);
+//         ...
+//         auto written = co_await application::co_write(core, update);
+//     }, boost::asio::detached);
+//
+// A waiting procedure holds no thread: it is resumed on its own executor once the response (or
+// its timeout) completes the request, so many procedures can share a few workers. Passing a token
+// from core.newCancelToken() lets core.cancel() wake the procedure early.
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#if !defined(BOOST_ASIO_HAS_CO_AWAIT)
+#error "Coroutines.h needs C++20 coroutine support; configure with -DMODBUSCONFIG_COROUTINES=ON"
+#endif
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "application_layer.h"
+
+namespace application {
+
+namespace detail {
+
+// Turns an asio completion handler into an ApplicationCore callback. Those run on a scheduler
+// strand or inline in the initiating call, so the handler is always posted to its own executor,
+// which is kept busy until then.
+template <typename Outcome, typename Handler>
+auto resumeOn(Handler handler) {
+    auto executor = boost::asio::get_associated_executor(handler);
+    using WorkGuard = decltype(boost::asio::make_work_guard(executor));
+    auto state = std::make_shared<std::pair<Handler, WorkGuard>>(std::move(handler), boost::asio::make_work_guard(executor));
+
+    return [state](Outcome outcome) {
+        boost::asio::post(state->second.get_executor(), [state, outcome = std::move(outcome)]() mutable {
+            auto handler = std::move(state->first);
+            state->second.reset();
+            handler(std::move(outcome));
+        });
+    };
+}
+
+} // namespace detail
+
+template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+auto co_read(ApplicationCore& core, protocol::ModbusRequest request, std::uint32_t timeoutMs = 2000,
+             std::uint32_t maxAgeMs = 0, ApplicationCore::CancelToken cancelToken = 0, CompletionToken&& token = {}) {
+    return boost::asio::async_initiate<CompletionToken, void(ReadOutcome)>(
+        [&core, request = std::move(request), timeoutMs, maxAgeMs, cancelToken](auto handler) {
+            core.readAsync(request, timeoutMs, detail::resumeOn<ReadOutcome>(std::move(handler)), maxAgeMs, cancelToken);
+        },
+        token);
+}
+
+template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+auto co_write(ApplicationCore& core, protocol::ModbusRequest request, std::uint32_t timeoutMs = 2000,
+              ApplicationCore::CancelToken cancelToken = 0, CompletionToken&& token = {}) {
+    return boost::asio::async_initiate<CompletionToken, void(WriteOutcome)>(
+        [&core, request = std::move(request), timeoutMs, cancelToken](auto handler) {
+            core.writeAsync(request, timeoutMs, detail::resumeOn<WriteOutcome>(std::move(handler)), cancelToken);
+        },
+        token);
+}
+
+template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+auto co_read_group(ApplicationCore& core, std::vector<protocol::ModbusRequest> requests, std::uint32_t timeoutMs = 2000,
+                   bool coalesce = true, ApplicationCore::CancelToken cancelToken = 0, CompletionToken&& token = {}) {
+    return boost::asio::async_initiate<CompletionToken, void(GroupOutcome)>(
+        [&core, requests = std::move(requests), timeoutMs, coalesce, cancelToken](auto handler) {
+            core.groupAsync(requests, timeoutMs, coalesce, detail::resumeOn<GroupOutcome>(std::move(handler)), cancelToken);
+        },
+        token);
+}
+
+} // namespace application
@@ -0,0 +1,253 @@
+#include "PollingEngine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace application {
+
+namespace {
+
+// Items due within this share of their own period join the current batch, so neighbours with
+// slightly different phases still coalesce into one request.
+constexpr int kEarlyDivisor = 8;
+
+constexpr double kJitterGain = 0.125;
+
+} // namespace
+
+PollingEngine::PollingEngine(TaskScheduler& scheduler, ReadPlanner& planner, ReadExecutor executor)
+    : scheduler_(scheduler), planner_(planner), executor_(std::move(executor)) {}
+
+PollingEngine::~PollingEngine() {
+    stop();
+}
+
+bool PollingEngine::add(const PollItemConfig& config, std::uint64_t& id, std::string& error) {
+    if (!protocol::isReadFunction(config.function)) {
+        error = "Polling supports read functions only";
+        return false;
+    }
+    if (config.count == 0 || config.count > protocol::kMaxReadRegisters) {
+        error = "count must be 1.." + std::to_string(protocol::kMaxReadRegisters);
+        return false;
+    }
+    if (config.period < kMinPeriod) {
+        error = "period must be at least " + std::to_string(kMinPeriod.count()) + " ms";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+        error = "Polling engine is stopped";
+        return false;
+    }
+    id = nextId_++;
+    Entry entry;
+    entry.state.id = id;
+    entry.state.config = config;
+    entry.deadline = Clock::now();
+    entries_.emplace(id, std::move(entry));
+    armLocked(Clock::now());
+    return true;
+}
+
+bool PollingEngine::remove(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.erase(id) == 0) {
+        return false;
+    }
+    armLocked(Clock::now());
+    return true;
+}
+
+void PollingEngine::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    armLocked(Clock::now());
+}
+
+std::vector<PollItemState> PollingEngine::items() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<PollItemState> items;
+    items.reserve(entries_.size());
+    for (const auto& [_, entry] : entries_) {
+        items.push_back(entry.state);
+    }
+    return items;
+}
+
+std::optional<PollItemState> PollingEngine::item(std::uint64_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(id);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    return it->second.state;
+}
+
+PollingStats PollingEngine::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PollingStats stats = stats_;
+    stats.items = entries_.size();
+    const auto elapsed = Clock::now() - startedAt_;
+    stats.busyRatio = elapsed.count() > 0 ? static_cast<double>(busy_.count()) / static_cast<double>(elapsed.count()) : 0.0;
+    return stats;
+}
+
+void PollingEngine::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    ++generation_;
+    if (timerId_ != 0) {
+        scheduler_.cancel(timerId_);
+        timerId_ = 0;
+    }
+    armedFor_.reset();
+}
+
+void PollingEngine::runCycle(std::uint64_t generation) {
+    std::vector<std::uint64_t> dueIds;
+    std::vector<protocol::ModbusRequest> dueRequests;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || generation != generation_) {
+            return;
+        }
+        timerId_ = 0;
+        armedFor_.reset();
+        cycleActive_ = true;
+
+        const auto now = Clock::now();
+        std::vector<std::pair<Clock::time_point, std::uint64_t>> due;
+        for (const auto& [id, entry] : entries_) {
+            if (entry.deadline <= now + entry.state.config.period / kEarlyDivisor) {
+                due.emplace_back(entry.deadline, id);
+            }
+        }
+        std::sort(due.begin(), due.end());
+
+        for (const auto& [_, id] : due) {
+            const auto& config = entries_.at(id).state.config;
+            protocol::ModbusRequest request;
+            request.slaveId = config.slaveId;
+            request.function = config.function;
+            request.startAddress = config.address;
+            request.count = config.count;
+            dueIds.push_back(id);
+            dueRequests.push_back(request);
+        }
+    }
+
+    if (dueRequests.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cycleActive_ = false;
+        armLocked(Clock::now());
+        return;
+    }
+
+    // The planner orders merged reads by their first item, which is EDF order here.
+    auto planned = planner_.plan(dueRequests);
+    if (planned.size() > kMaxRequestsPerCycle) {
+        planned.resize(kMaxRequestsPerCycle);
+    }
+
+    std::vector<protocol::ModbusRequest> wire;
+    wire.reserve(planned.size());
+    for (const auto& read : planned) {
+        wire.push_back(read.request);
+    }
+
+    // The worker is free while the batch is on the wire; the cycle ends in finishCycle.
+    const auto started = Clock::now();
+    executor_(wire, requestTimeoutMs_.load(),
+              [this, planned = std::move(planned), dueIds = std::move(dueIds), dueRequests = std::move(dueRequests),
+               started](std::vector<ReadOutcome> outcomes) { finishCycle(planned, dueIds, dueRequests, outcomes, started); });
+}
+
+void PollingEngine::finishCycle(const std::vector<PlannedRead>& planned, const std::vector<std::uint64_t>& dueIds,
+                                const std::vector<protocol::ModbusRequest>& dueRequests,
+                                const std::vector<ReadOutcome>& outcomes, Clock::time_point started) {
+    const auto finished = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.cycles;
+    stats_.requests += planned.size();
+    busy_ += finished - started;
+
+    for (std::size_t i = 0; i < planned.size(); ++i) {
+        stats_.registersRead += planned[i].request.count;
+        for (const auto index : planned[i].items) {
+            stats_.registersWanted += dueRequests[index].count;
+
+            const auto it = entries_.find(dueIds[index]);
+            if (it == entries_.end()) {
+                continue;  // removed while the batch was on the wire
+            }
+            auto& entry = it->second;
+            auto& state = entry.state;
+
+            const auto lateUs = std::chrono::duration_cast<std::chrono::microseconds>(started - entry.deadline).count();
+            state.jitterAvgUs += kJitterGain * (static_cast<double>(std::llabs(lateUs)) - state.jitterAvgUs);
+            state.jitterMaxUs = std::max<std::int64_t>(state.jitterMaxUs, std::llabs(lateUs));
+            ++state.scans;
+
+            const auto& outcome = outcomes[i];
+            if (outcome.ok && ReadPlanner::extract(outcome.result, dueRequests[index], state.latest)) {
+                state.hasValue = true;
+                state.lastOk = true;
+                state.lastError.clear();
+                state.sampledAt = std::chrono::system_clock::now();
+            } else {
+                ++state.errors;
+                state.lastOk = false;
+                state.lastError = outcome.ok ? "Short Modbus read response" : outcome.error;
+            }
+
+            // Fixed rate; periods that went by entirely while we were busy count as overruns.
+            const auto period = state.config.period;
+            entry.deadline += period;
+            if (entry.deadline <= finished) {
+                const auto missed = (finished - entry.deadline) / period + 1;
+                state.overruns += static_cast<std::uint64_t>(missed);
+                entry.deadline += missed * period;
+            }
+        }
+    }
+
+    cycleActive_ = false;
+    armLocked(finished);
+}
+
+void PollingEngine::armLocked(Clock::time_point now) {
+    if (stopped_ || cycleActive_) {
+        return;  // a running cycle re-arms itself when it finishes
+    }
+
+    std::optional<Clock::time_point> earliest;
+    for (const auto& [_, entry] : entries_) {
+        if (!earliest || entry.deadline < *earliest) {
+            earliest = entry.deadline;
+        }
+    }
+    if (timerId_ != 0 && earliest && armedFor_ && *armedFor_ <= *earliest) {
+        return;
+    }
+
+    if (timerId_ != 0) {
+        scheduler_.cancel(timerId_);
+        timerId_ = 0;
+    }
+    armedFor_.reset();
+    ++generation_;
+    if (!earliest) {
+        return;
+    }
+
+    const auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(std::max(*earliest - now, Clock::duration::zero()));
+    const auto generation = generation_;
+    timerId_ = scheduler_.postDelayed(delay, [this, generation]() { runCycle(generation); }, kStrandKey);
+    armedFor_ = earliest;
+}
+
+} // namespace application
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ReadPlanner.h"
+#include "ReadResult.h"
+#include "TaskScheduler.h"
+
+namespace application {
+
+struct PollItemConfig {
+    std::uint8_t slaveId = 1;
+    protocol::FunctionCode function = protocol::FunctionCode::ReadHoldingRegisters;
+    std::uint16_t address = 0;
+    std::uint16_t count = 1;
+    std::chrono::milliseconds period{1000};
+};
+
+// Timing statistics and the latest sample of one scan-list entry.
+struct PollItemState {
+    std::uint64_t id = 0;
+    PollItemConfig config;
+
+    std::uint64_t scans = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t overruns = 0;      // whole periods that passed without a scan
+    double jitterAvgUs = 0.0;        // EWMA of |scan start - deadline|
+    std::int64_t jitterMaxUs = 0;
+
+    bool hasValue = false;
+    bool lastOk = false;
+    std::string lastError;
+    ReadResult latest;
+    std::chrono::system_clock::time_point sampledAt;
+};
+
+struct PollingStats {
+    std::uint64_t items = 0;
+    std::uint64_t cycles = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t registersWanted = 0;  // registers the due items asked for
+    std::uint64_t registersRead = 0;    // registers actually put on the wire (includes bridged gaps)
+    double busyRatio = 0.0;             // share of wall time spent with reads outstanding
+};
+
+// Cyclic scanner over the active transport. Due items are taken earliest-deadline-first, coalesced
+// through ReadPlanner and issued as one pipelined batch; the next cycle is armed for the earliest
+// remaining deadline. Because an overdue item's deadline never moves, slow periods are not starved.
+// Cycles run on the scheduler, so the owner must join the scheduler before destroying the engine.
+class PollingEngine {
+public:
+    // Issues the batch without blocking and reports one outcome per request, in order, once all of
+    // them are done. The report may come inline or from any thread.
+    using ReadExecutor = std::function<void(const std::vector<protocol::ModbusRequest>&, std::uint32_t,
+                                            std::function<void(std::vector<ReadOutcome>)>)>;
+
+    PollingEngine(TaskScheduler& scheduler, ReadPlanner& planner, ReadExecutor executor);
+    ~PollingEngine();
+
+    PollingEngine(const PollingEngine&) = delete;
+    PollingEngine& operator=(const PollingEngine&) = delete;
+
+    bool add(const PollItemConfig& config, std::uint64_t& id, std::string& error);
+    bool remove(std::uint64_t id);
+    void clear();
+
+    std::vector<PollItemState> items() const;
+    std::optional<PollItemState> item(std::uint64_t id) const;
+    PollingStats stats() const;
+
+    void setRequestTimeout(std::uint32_t timeoutMs) { requestTimeoutMs_ = timeoutMs; }
+    void stop();
+
+    static constexpr std::chrono::milliseconds kMinPeriod{10};
+    // Upper bound on requests per cycle, so a newly due short-period item waits at most one batch.
+    static constexpr std::size_t kMaxRequestsPerCycle = 8;
+    static constexpr TaskScheduler::StrandKey kStrandKey = std::numeric_limits<TaskScheduler::StrandKey>::max();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        PollItemState state;
+        Clock::time_point deadline;
+    };
+
+    void runCycle(std::uint64_t generation);
+    void finishCycle(const std::vector<PlannedRead>& planned, const std::vector<std::uint64_t>& dueIds,
+                     const std::vector<protocol::ModbusRequest>& dueRequests, const std::vector<ReadOutcome>& outcomes,
+                     Clock::time_point started);
+    void armLocked(Clock::time_point now);
+
+    TaskScheduler& scheduler_;
+    ReadPlanner& planner_;
+    ReadExecutor executor_;
+    std::atomic<std::uint32_t> requestTimeoutMs_{2000};
+
+    mutable std::mutex mutex_;
+    std::map<std::uint64_t, Entry> entries_;
+    std::uint64_t nextId_ = 1;
+    bool stopped_ = false;
+    bool cycleActive_ = false;
+    TaskScheduler::TaskId timerId_ = 0;
+    std::uint64_t generation_ = 0;  // bumped on every re-arm; a cycle from an older arm exits at once
+    std::optional<Clock::time_point> armedFor_;
+
+    Clock::time_point startedAt_ = Clock::now();
+    Clock::duration busy_{};
+    PollingStats stats_;
+};
+
+} // namespace application
@@ -0,0 +1,133 @@
+#include "ReadPlanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace application {
+
+namespace {
+
+// Weight of a new round-trip sample (1/8, as in TCP SRTT).
+constexpr double kRoundTripGain = 0.125;
+
+bool mergeable(const protocol::ModbusRequest& item) {
+    return protocol::isReadFunction(item.function) && item.count > 0 && item.count <= protocol::kMaxReadRegisters;
+}
+
+} // namespace
+
+ReadPlanner::ReadPlanner()
+    : registerCostUs_(kTcpRegisterCostUs), requestOverheadUs_(kTcpRequestOverheadUs) {}
+
+std::vector<PlannedRead> ReadPlanner::plan(const std::vector<protocol::ModbusRequest>& items) const {
+    const std::uint32_t gap = maxGap();
+
+    // Group by (slave, function); std::map keeps the output stable between calls.
+    std::map<std::pair<std::uint8_t, std::uint8_t>, std::vector<std::size_t>> groups;
+    std::vector<PlannedRead> planned;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (!mergeable(items[i])) {
+            planned.push_back(PlannedRead{items[i], {i}});
+            continue;
+        }
+        groups[{items[i].slaveId, static_cast<std::uint8_t>(items[i].function)}].push_back(i);
+    }
+
+    for (auto& [_, indices] : groups) {
+        std::stable_sort(indices.begin(), indices.end(), [&](std::size_t a, std::size_t b) {
+            return items[a].startAddress < items[b].startAddress;
+        });
+
+        PlannedRead current;
+        std::uint32_t start = 0;
+        std::uint32_t end = 0;
+        for (const auto index : indices) {
+            const auto& item = items[index];
+            const std::uint32_t itemStart = item.startAddress;
+            const std::uint32_t itemEnd = itemStart + item.count;
+
+            const bool fits = !current.items.empty() && itemStart <= end + gap &&
+                              std::max(end, itemEnd) - start <= protocol::kMaxReadRegisters;
+            if (fits) {
+                end = std::max(end, itemEnd);
+                current.items.push_back(index);
+                continue;
+            }
+
+            if (!current.items.empty()) {
+                current.request.count = static_cast<std::uint16_t>(end - start);
+                planned.push_back(std::move(current));
+            }
+            current = PlannedRead{item, {index}};
+            start = itemStart;
+            end = itemEnd;
+        }
+        if (!current.items.empty()) {
+            current.request.count = static_cast<std::uint16_t>(end - start);
+            planned.push_back(std::move(current));
+        }
+    }
+
+    // Issue merged reads in the order the caller first asked for them.
+    std::sort(planned.begin(), planned.end(), [](const PlannedRead& a, const PlannedRead& b) {
+        return *std::min_element(a.items.begin(), a.items.end()) < *std::min_element(b.items.begin(), b.items.end());
+    });
+    return planned;
+}
+
+bool ReadPlanner::extract(const ReadResult& merged, const protocol::ModbusRequest& item, ReadResult& out) {
+    if (item.startAddress < merged.address) {
+        return false;
+    }
+    const std::size_t offset = item.startAddress - merged.address;
+    if (offset + item.count > merged.values.size()) {
+        return false;
+    }
+
+    out.slaveId = merged.slaveId;
+    out.function = merged.function;
+    out.address = item.startAddress;
+    out.count = item.count;
+    out.values = protocol::RegisterBlock{};
+    for (std::size_t i = 0; i < item.count; ++i) {
+        out.values.push_back(merged.values[offset + i]);
+    }
+    return true;
+}
+
+void ReadPlanner::configureLink(double registerCostUs, double requestOverheadUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    registerCostUs_ = std::max(registerCostUs, 0.001);
+    requestOverheadUs_ = std::max(requestOverheadUs, 0.0);
+}
+
+void ReadPlanner::recordRoundTrip(std::chrono::microseconds roundTrip, std::uint16_t registers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double overhead = std::max(0.0, static_cast<double>(roundTrip.count()) - registers * registerCostUs_);
+    requestOverheadUs_ += kRoundTripGain * (overhead - requestOverheadUs_);
+}
+
+void ReadPlanner::setGapLimit(std::uint16_t registers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gapLimit_ = std::min<std::uint16_t>(registers, protocol::kMaxReadRegisters);
+}
+
+std::uint16_t ReadPlanner::maxGap() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxGapLocked();
+}
+
+ReadPlannerStats ReadPlanner::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ReadPlannerStats{registerCostUs_, requestOverheadUs_, maxGapLocked()};
+}
+
+std::uint16_t ReadPlanner::maxGapLocked() const {
+    // Bridging a gap of g registers is worth it while g * registerCost < requestOverhead.
+    const double breakEven = std::floor(requestOverheadUs_ / registerCostUs_);
+    return static_cast<std::uint16_t>(std::min<double>(breakEven, gapLimit_));
+}
+
+} // namespace application
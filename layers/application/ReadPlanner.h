@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "ReadResult.h"
+#include "layers/protocol/protocol_layer.h"
+
+namespace application {
+
+// One Modbus read as it goes on the wire, plus the caller's items it serves.
+struct PlannedRead {
+    protocol::ModbusRequest request;
+    std::vector<std::size_t> items;  // indices into the list passed to ReadPlanner::plan
+};
+
+struct ReadPlannerStats {
+    double registerCostUs = 0.0;
+    double requestOverheadUs = 0.0;
+    std::uint16_t maxGap = 0;
+};
+
+// Coalesces register reads of the same slave and function code into the fewest legal requests.
+// Two ranges are merged when reading the registers between them costs less link time than one
+// more request/response exchange; the exchange cost is an EWMA of measured round trips.
+class ReadPlanner {
+public:
+    ReadPlanner();
+
+    std::vector<PlannedRead> plan(const std::vector<protocol::ModbusRequest>& items) const;
+
+    // Copies the registers of `item` out of the merged read that covered it.
+    static bool extract(const ReadResult& merged, const protocol::ModbusRequest& item, ReadResult& out);
+
+    // Resets the cost model for a new link: wire time of one register and an initial per-request overhead.
+    void configureLink(double registerCostUs, double requestOverheadUs);
+    void recordRoundTrip(std::chrono::microseconds roundTrip, std::uint16_t registers);
+
+    // Hard cap on the gap bridged between two ranges; 0 merges only overlapping or adjacent ranges.
+    void setGapLimit(std::uint16_t registers);
+
+    std::uint16_t maxGap() const;
+    ReadPlannerStats stats() const;
+
+    static constexpr std::uint16_t kDefaultGapLimit = 32;
+    // Starting point for a LAN Modbus/TCP link: ~100 Mbit/s per register, ~1 ms per exchange.
+    static constexpr double kTcpRegisterCostUs = 0.16;
+    static constexpr double kTcpRequestOverheadUs = 1000.0;
+
+private:
+    std::uint16_t maxGapLocked() const;
+
+    mutable std::mutex mutex_;
+    double registerCostUs_;
+    double requestOverheadUs_;
+    std::uint16_t gapLimit_ = kDefaultGapLimit;
+};
+
+} // namespace application
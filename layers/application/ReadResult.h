@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "layers/protocol/protocol_layer.h"
+
+namespace application {
+
+// Outcome of a completed register read; JSON is only built from it at the API boundary.
+struct ReadResult {
+    std::uint8_t slaveId = 0;
+    protocol::FunctionCode function = protocol::FunctionCode::ReadHoldingRegisters;
+    std::uint16_t address = 0;
+    std::uint16_t count = 0;
+    protocol::RegisterBlock values;
+};
+
+// Per-request outcome when a batch keeps going past individual failures.
+struct ReadOutcome {
+    bool ok = false;
+    std::string error;
+    ReadResult result;
+    std::uint8_t exceptionCode = 0;  // non-zero when the device answered with a Modbus exception
+};
+
+struct WriteOutcome {
+    bool ok = false;
+    std::string error;
+    std::uint8_t exceptionCode = 0;
+};
+
+// Outcome of a whole read group: one result per requested item, in request order.
+struct GroupOutcome {
+    bool ok = false;
+    std::string error;
+    std::vector<ReadResult> results;
+    std::uint8_t exceptionCode = 0;
+};
+
+} // namespace application
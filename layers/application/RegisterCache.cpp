@@ -0,0 +1,195 @@
+#include "RegisterCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+namespace application {
+
+std::vector<RegisterRange> RegisterCache::lookup(std::uint8_t slaveId, protocol::FunctionCode function, std::uint16_t address,
+                                                 std::uint16_t count, std::chrono::milliseconds maxAge, std::uint16_t* out) {
+    assert(static_cast<std::uint32_t>(address) + count <= 0x10000);
+    const auto now = Clock::now();
+    std::vector<RegisterRange> missing;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto oldest = now - std::min(maxAge, ttl_);
+    std::uint64_t fresh = 0;
+
+    const Page* page = nullptr;
+    std::uint32_t pageIndex = UINT32_MAX;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint32_t reg = static_cast<std::uint32_t>(address) + i;
+        if (reg / kPageSize != pageIndex) {
+            pageIndex = reg / kPageSize;
+            const auto it = pages_.find(pageKey(slaveId, function, pageIndex));
+            page = it == pages_.end() ? nullptr : &it->second;
+        }
+
+        const auto slot = reg % kPageSize;
+        const bool valid = page && page->seenAt[slot] != Clock::time_point{} && page->seenAt[slot] >= oldest;
+        if (valid) {
+            out[i] = page->values[slot];
+            ++fresh;
+            continue;
+        }
+
+        out[i] = 0;
+        if (!missing.empty() && missing.back().address + missing.back().count == reg) {
+            ++missing.back().count;
+        } else {
+            missing.push_back(RegisterRange{static_cast<std::uint16_t>(reg), 1});
+        }
+    }
+
+    auto& stats = stats_[slaveId];
+    stats.slaveId = slaveId;
+    stats.registersFromCache += fresh;
+    stats.registersFetched += count - fresh;
+    if (missing.empty()) {
+        ++stats.hits;
+    } else {
+        ++stats.misses;
+    }
+    return missing;
+}
+
+void RegisterCache::store(std::uint8_t slaveId, protocol::FunctionCode function, std::uint16_t address,
+                          const std::uint16_t* values, std::size_t count, Clock::time_point seenAt) {
+    const auto table = tableOf(function);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Page* page = nullptr;
+    std::uint32_t pageIndex = UINT32_MAX;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint32_t reg = static_cast<std::uint32_t>(address) + static_cast<std::uint32_t>(i);
+        if (reg > 0xFFFF) {
+            break;
+        }
+        if (reg / kPageSize != pageIndex) {
+            pageIndex = reg / kPageSize;
+            page = &pages_[pageKey(slaveId, function, pageIndex)];
+            page->newest = std::max(page->newest, seenAt);
+        }
+        const auto slot = reg % kPageSize;
+        if (page->seenAt[slot] == Clock::time_point{} || page->values[slot] != values[i]) {
+            changeLog_.push_back(RegisterChange{++sequence_, slaveId, table, static_cast<std::uint16_t>(reg), values[i]});
+        }
+        page->values[slot] = values[i];
+        page->seenAt[slot] = seenAt;
+    }
+    while (changeLog_.size() > changeLogCapacity_) {
+        changeLog_.pop_front();
+    }
+}
+
+void RegisterCache::setTtl(std::chrono::milliseconds ttl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = std::max(ttl, std::chrono::milliseconds(1));
+}
+
+std::chrono::milliseconds RegisterCache::ttl() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ttl_;
+}
+
+std::size_t RegisterCache::prune(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t dropped = 0;
+    for (auto it = pages_.begin(); it != pages_.end();) {
+        if (it->second.newest + ttl_ < now) {
+            it = pages_.erase(it);
+            ++dropped;
+        } else {
+            ++it;
+        }
+    }
+    return dropped;
+}
+
+void RegisterCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pages_.clear();
+}
+
+ChangeSet RegisterCache::changesSince(std::uint64_t cursor, std::size_t limit) const {
+    ChangeSet set;
+    limit = std::max<std::size_t>(limit, 1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    set.cursor = sequence_;
+
+    // Entries up to `cursor` must still be in the log for nothing to have been missed in between.
+    const std::uint64_t first = changeLog_.empty() ? sequence_ + 1 : changeLog_.front().sequence;
+    if (cursor > sequence_ || cursor + 1 < first) {
+        set.reset = true;
+        return set;
+    }
+
+    // Later changes of a register overwrite its earlier entry in the set.
+    std::unordered_map<std::uint32_t, std::size_t> positions;
+    for (auto it = changeLog_.begin() + static_cast<std::ptrdiff_t>(cursor + 1 - first); it != changeLog_.end(); ++it) {
+        const auto key = (static_cast<std::uint32_t>(it->slaveId) << 24) | (static_cast<std::uint32_t>(it->table) << 16) | it->address;
+        const auto position = positions.find(key);
+        if (position != positions.end()) {
+            set.changes[position->second] = *it;
+            continue;
+        }
+        if (set.changes.size() == limit) {
+            set.cursor = it->sequence - 1;
+            set.more = true;
+            break;
+        }
+        positions.emplace(key, set.changes.size());
+        set.changes.push_back(*it);
+    }
+    return set;
+}
+
+std::uint64_t RegisterCache::changeSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sequence_;
+}
+
+void RegisterCache::setChangeLogCapacity(std::size_t entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    changeLogCapacity_ = std::max<std::size_t>(entries, 1);
+    while (changeLog_.size() > changeLogCapacity_) {
+        changeLog_.pop_front();
+    }
+}
+
+std::size_t RegisterCache::changeLogCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return changeLogCapacity_;
+}
+
+std::size_t RegisterCache::changeLogSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return changeLog_.size();
+}
+
+std::vector<DeviceCacheStats> RegisterCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DeviceCacheStats> stats;
+    stats.reserve(stats_.size());
+    for (const auto& [_, device] : stats_) {
+        stats.push_back(device);
+    }
+    return stats;
+}
+
+std::size_t RegisterCache::pageCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pages_.size();
+}
+
+std::uint32_t RegisterCache::pageKey(std::uint8_t slaveId, protocol::FunctionCode function, std::uint32_t pageIndex) noexcept {
+    return (static_cast<std::uint32_t>(slaveId) << 24) | (static_cast<std::uint32_t>(tableOf(function)) << 16) | pageIndex;
+}
+
+protocol::FunctionCode RegisterCache::tableOf(protocol::FunctionCode function) noexcept {
+    // Writes land in the holding table.
+    return function == protocol::FunctionCode::ReadInputRegisters ? protocol::FunctionCode::ReadInputRegisters
+                                                                  : protocol::FunctionCode::ReadHoldingRegisters;
+}
+
+} // namespace application
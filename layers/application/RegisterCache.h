@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "layers/protocol/protocol_layer.h"
+
+namespace application {
+
+struct RegisterRange {
+    std::uint16_t address = 0;
+    std::uint16_t count = 0;
+};
+
+struct DeviceCacheStats {
+    std::uint8_t slaveId = 0;
+    std::uint64_t hits = 0;                // reads answered entirely from the cache
+    std::uint64_t misses = 0;              // reads that needed the device for at least one register
+    std::uint64_t registersFromCache = 0;
+    std::uint64_t registersFetched = 0;
+};
+
+// One entry of the change log: a register that took a new value.
+struct RegisterChange {
+    std::uint64_t sequence = 0;
+    std::uint8_t slaveId = 0;
+    protocol::FunctionCode table = protocol::FunctionCode::ReadHoldingRegisters;
+    std::uint16_t address = 0;
+    std::uint16_t value = 0;
+};
+
+struct ChangeSet {
+    std::vector<RegisterChange> changes;  // each register once, with its latest value
+    std::uint64_t cursor = 0;             // pass back to get the changes after these
+    bool reset = false;  // the cursor is older than the log (or from an earlier run): re-read, then go on from `cursor`
+    bool more = false;   // cut short by the limit; call again with `cursor`
+};
+
+// Sparse process image of the holding and input tables, paged by address and keyed by
+// (slave, table). Every register carries the time it was last seen on the wire, so a read can
+// take what is young enough and fetch only the stale or missing sub-ranges.
+class RegisterCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Fills `out[0..count)` with cached values and returns the ranges older than `maxAge` (or never
+    // seen); an empty result is a full hit. Updates the hit/miss counters of the slave. The range must
+    // end within the address space.
+    std::vector<RegisterRange> lookup(std::uint8_t slaveId, protocol::FunctionCode function, std::uint16_t address,
+                                      std::uint16_t count, std::chrono::milliseconds maxAge, std::uint16_t* out);
+
+    // Records values seen on the wire: read responses, or write echoes for the holding table.
+    void store(std::uint8_t slaveId, protocol::FunctionCode function, std::uint16_t address,
+               const std::uint16_t* values, std::size_t count, Clock::time_point seenAt = Clock::now());
+
+    // Pages whose newest register is older than the TTL are dropped; lookups never serve them either.
+    void setTtl(std::chrono::milliseconds ttl);
+    std::chrono::milliseconds ttl() const;
+    std::size_t prune(Clock::time_point now = Clock::now());
+    void clear();
+
+    // Every store that gives a register a new value (or its first one) appends to a bounded change log
+    // under the next sequence number; the oldest entries drop out once it is full. clear() keeps the
+    // log, so cursors stay valid across it.
+    ChangeSet changesSince(std::uint64_t cursor, std::size_t limit) const;
+    std::uint64_t changeSequence() const;
+    void setChangeLogCapacity(std::size_t entries);
+    std::size_t changeLogCapacity() const;
+    std::size_t changeLogSize() const;
+
+    std::vector<DeviceCacheStats> stats() const;
+    std::size_t pageCount() const;
+
+    static constexpr std::size_t kPageSize = 64;
+    static constexpr std::chrono::milliseconds kDefaultTtl{60000};
+    static constexpr std::size_t kDefaultChangeLogCapacity = 65536;
+
+private:
+    struct Page {
+        std::array<std::uint16_t, kPageSize> values{};
+        std::array<Clock::time_point, kPageSize> seenAt{};  // epoch means never seen
+        Clock::time_point newest{};
+    };
+
+    // slave << 24 | table << 16 | page index
+    static std::uint32_t pageKey(std::uint8_t slaveId, protocol::FunctionCode function, std::uint32_t pageIndex) noexcept;
+    static protocol::FunctionCode tableOf(protocol::FunctionCode function) noexcept;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::uint32_t, Page> pages_;
+    std::map<std::uint8_t, DeviceCacheStats> stats_;
+    std::chrono::milliseconds ttl_ = kDefaultTtl;
+
+    std::deque<RegisterChange> changeLog_;  // sequence numbers are consecutive, so a cursor maps to an index
+    std::size_t changeLogCapacity_ = kDefaultChangeLogCapacity;
+    std::uint64_t sequence_ = 0;
+};
+
+} // namespace application
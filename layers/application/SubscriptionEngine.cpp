@@ -0,0 +1,311 @@
+#include "SubscriptionEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace application {
+
+namespace {
+
+// Threshold of a register that has never been seen: no difference exceeds it.
+constexpr std::int32_t kUnseen = std::numeric_limits<std::int32_t>::max();
+// Threshold of a register seen for the first time: any difference, including none, exceeds it.
+constexpr std::int32_t kFresh = -1;
+
+// Branch-free so the compiler can vectorize it; values are widened so differences never wrap.
+std::size_t countExceeding(const std::uint16_t* current, const std::uint16_t* reference, const std::int32_t* threshold,
+                           std::size_t count) noexcept {
+    std::size_t exceeding = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::int32_t diff = static_cast<std::int32_t>(current[i]) - static_cast<std::int32_t>(reference[i]);
+        exceeding += static_cast<std::size_t>((diff < 0 ? -diff : diff) > threshold[i]);
+    }
+    return exceeding;
+}
+
+} // namespace
+
+SubscriptionEngine::SubscriptionEngine(TaskScheduler& scheduler) : scheduler_(scheduler) {}
+
+SubscriptionEngine::~SubscriptionEngine() {
+    stop();
+}
+
+bool SubscriptionEngine::add(const SubscriptionConfig& config, std::uint64_t& id, std::string& error) {
+    if (config.function != protocol::FunctionCode::ReadHoldingRegisters &&
+        config.function != protocol::FunctionCode::ReadInputRegisters) {
+        error = "Subscriptions cover holding or input registers only";
+        return false;
+    }
+    if (config.count == 0 || config.address + static_cast<std::uint32_t>(config.count) > 0x10000) {
+        error = "Register range is out of bounds";
+        return false;
+    }
+    if (!(config.deadband >= 0.0)) {
+        error = "deadband must not be negative";
+        return false;
+    }
+    if (config.minInterval.count() < 0 || config.maxInterval.count() < 0) {
+        error = "intervals must not be negative";
+        return false;
+    }
+    if (config.maxInterval.count() > 0 && config.maxInterval < config.minInterval) {
+        error = "max interval must not be shorter than min interval";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+        error = "Subscription engine is stopped";
+        return false;
+    }
+    id = nextId_++;
+    auto& subscription = subscriptions_[id];
+    subscription.id = id;
+    subscription.config = config;
+    subscription.current.assign(config.count, 0);
+    subscription.reference.assign(config.count, 0);
+    subscription.threshold.assign(config.count, kUnseen);
+    subscription.lastReport = Clock::now();
+
+    auto& device = byDevice_[deviceKey(config.slaveId, config.function)];
+    const auto position = std::upper_bound(device.byAddress.begin(), device.byAddress.end(), config.address,
+                                           [](std::uint16_t address, const Subscription* other) { return address < other->config.address; });
+    device.byAddress.insert(position, &subscription);
+    device.widest = std::max<std::uint32_t>(device.widest, config.count);
+    ++stats_.subscriptions;
+    stats_.registers += config.count;
+    active_ = true;
+    if (config.maxInterval.count() > 0) {
+        armLocked(Clock::now() + config.maxInterval);
+    }
+    return true;
+}
+
+bool SubscriptionEngine::remove(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = subscriptions_.find(id);
+    if (it == subscriptions_.end()) {
+        return false;
+    }
+
+    const auto key = deviceKey(it->second.config.slaveId, it->second.config.function);
+    auto& device = byDevice_[key];
+    device.byAddress.erase(std::remove(device.byAddress.begin(), device.byAddress.end(), &it->second), device.byAddress.end());
+    device.widest = 0;
+    for (const auto* other : device.byAddress) {
+        device.widest = std::max<std::uint32_t>(device.widest, other->config.count);
+    }
+    if (device.byAddress.empty()) {
+        byDevice_.erase(key);
+    }
+    --stats_.subscriptions;
+    stats_.registers -= it->second.config.count;
+    subscriptions_.erase(it);
+    active_ = !subscriptions_.empty();
+    return true;
+}
+
+SubscriptionEngine::SinkId SubscriptionEngine::addSink(Sink sink) {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    const auto id = nextSinkId_++;
+    sinks_.emplace(id, std::move(sink));
+    return id;
+}
+
+void SubscriptionEngine::removeSink(SinkId id) {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    sinks_.erase(id);
+}
+
+void SubscriptionEngine::ingest(const ReadResult& update) {
+    if (!active_) {
+        return;
+    }
+
+    std::vector<ChangeReport> reports;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto device = byDevice_.find(deviceKey(update.slaveId, update.function));
+    if (device == byDevice_.end()) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    const std::uint32_t updateEnd = update.address + static_cast<std::uint32_t>(update.values.size());
+    // Only subscriptions starting after update.address - widest can reach into the block.
+    const auto& index = device->second.byAddress;
+    const std::int64_t earliest = static_cast<std::int64_t>(update.address) - device->second.widest;
+    auto it = std::upper_bound(index.begin(), index.end(), earliest,
+                               [](std::int64_t address, const Subscription* other) { return address < other->config.address; });
+    for (; it != index.end() && (*it)->config.address < updateEnd; ++it) {
+        auto& subscription = **it;
+        const auto& config = subscription.config;
+        const std::uint32_t begin = std::max(config.address, update.address);
+        const std::uint32_t end = std::min(config.address + static_cast<std::uint32_t>(config.count), updateEnd);
+        if (begin >= end) {
+            continue;
+        }
+
+        const std::size_t offset = begin - config.address;
+        const std::size_t count = end - begin;
+        const auto* values = update.values.data() + (begin - update.address);
+        auto* current = subscription.current.data() + offset;
+        auto* threshold = subscription.threshold.data() + offset;
+        for (std::size_t i = 0; i < count; ++i) {
+            current[i] = values[i];
+            threshold[i] = threshold[i] == kUnseen ? kFresh : threshold[i];
+        }
+        ++stats_.samples;
+        stats_.registersCompared += count;
+
+        if (subscription.held ||
+            countExceeding(current, subscription.reference.data() + offset, threshold, count) == 0) {
+            continue;
+        }
+        const auto due = subscription.lastReport + config.minInterval;
+        if (now < due) {
+            subscription.held = true;
+            armLocked(due);
+            continue;
+        }
+        reports.push_back(reportLocked(subscription, false, now));
+    }
+    publishLocked(std::move(reports));
+}
+
+SubscriptionStats SubscriptionEngine::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void SubscriptionEngine::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    ++generation_;
+    if (timerId_ != 0) {
+        scheduler_.cancel(timerId_);
+        timerId_ = 0;
+    }
+    armedFor_.reset();
+}
+
+std::uint32_t SubscriptionEngine::deviceKey(std::uint8_t slaveId, protocol::FunctionCode function) noexcept {
+    const auto table = function == protocol::FunctionCode::ReadInputRegisters ? protocol::FunctionCode::ReadInputRegisters
+                                                                                : protocol::FunctionCode::ReadHoldingRegisters;
+    return (static_cast<std::uint32_t>(slaveId) << 8) | static_cast<std::uint32_t>(table);
+}
+
+std::int32_t SubscriptionEngine::thresholdFor(const SubscriptionConfig& config, std::uint16_t reference) noexcept {
+    // Register differences are whole numbers, so |diff| > deadband is |diff| > floor(deadband).
+    const double band = config.deadbandMode == DeadbandMode::Percent ? config.deadband * reference / 100.0 : config.deadband;
+    return static_cast<std::int32_t>(std::floor(std::min(band, 65535.0)));
+}
+
+ChangeReport SubscriptionEngine::reportLocked(Subscription& subscription, bool heartbeat, Clock::time_point now) {
+    const auto& config = subscription.config;
+    ChangeReport report;
+    report.subscriptionId = subscription.id;
+    report.slaveId = config.slaveId;
+    report.function = config.function;
+    report.heartbeat = heartbeat;
+    report.timestamp = std::chrono::system_clock::now();
+
+    for (std::size_t i = 0; i < subscription.current.size(); ++i) {
+        const std::int32_t diff =
+            static_cast<std::int32_t>(subscription.current[i]) - static_cast<std::int32_t>(subscription.reference[i]);
+        const bool include = heartbeat ? subscription.threshold[i] != kUnseen : std::abs(diff) > subscription.threshold[i];
+        if (!include) {
+            continue;
+        }
+        report.changes.push_back({static_cast<std::uint16_t>(config.address + i), subscription.current[i]});
+        subscription.reference[i] = subscription.current[i];
+        subscription.threshold[i] = thresholdFor(config, subscription.current[i]);
+    }
+
+    // A held change that drifted back into its deadband is simply dropped; the interval keeps running.
+    subscription.held = false;
+    if (report.changes.empty() && !heartbeat) {
+        return report;
+    }
+    subscription.lastReport = now;
+    ++stats_.reports;
+    stats_.registersReported += report.changes.size();
+    stats_.heartbeats += heartbeat ? 1 : 0;
+    if (config.maxInterval.count() > 0) {
+        armLocked(now + config.maxInterval);
+    }
+    return report;
+}
+
+void SubscriptionEngine::publishLocked(std::vector<ChangeReport> reports) {
+    reports.erase(std::remove_if(reports.begin(), reports.end(), [](const ChangeReport& report) { return report.changes.empty(); }),
+                  reports.end());
+    if (reports.empty()) {
+        return;
+    }
+    scheduler_.post(kStrandKey, [this, reports = std::move(reports)]() {
+        std::lock_guard<std::mutex> lock(sinksMutex_);
+        for (const auto& report : reports) {
+            for (const auto& [_, sink] : sinks_) {
+                sink(report);
+            }
+        }
+    });
+}
+
+void SubscriptionEngine::runTimer(std::uint64_t generation) {
+    std::vector<ChangeReport> reports;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_ || generation != generation_) {
+        return;
+    }
+    timerId_ = 0;
+    armedFor_.reset();
+
+    const auto now = Clock::now();
+    std::optional<Clock::time_point> next;
+    auto consider = [&next](Clock::time_point due) { next = next ? std::min(*next, due) : due; };
+    for (auto& [_, subscription] : subscriptions_) {
+        const auto& config = subscription.config;
+        if (subscription.held) {
+            const auto due = subscription.lastReport + config.minInterval;
+            if (due <= now) {
+                reports.push_back(reportLocked(subscription, false, now));
+            } else {
+                consider(due);
+            }
+        }
+        if (config.maxInterval.count() > 0) {
+            const auto due = subscription.lastReport + config.maxInterval;
+            if (due <= now) {
+                reports.push_back(reportLocked(subscription, true, now));
+            } else {
+                consider(due);
+            }
+        }
+    }
+    if (next) {
+        armLocked(*next);
+    }
+    publishLocked(std::move(reports));
+}
+
+void SubscriptionEngine::armLocked(Clock::time_point due) {
+    if (stopped_ || (timerId_ != 0 && armedFor_ && *armedFor_ <= due)) {
+        return;
+    }
+
+    if (timerId_ != 0) {
+        scheduler_.cancel(timerId_);
+        timerId_ = 0;
+    }
+    ++generation_;
+    // Rounded up: a timer that fires before `due` would only re-arm itself.
+    const auto delay = std::chrono::ceil<std::chrono::milliseconds>(std::max(due - Clock::now(), Clock::duration::zero()));
+    const auto generation = generation_;
+    timerId_ = scheduler_.postDelayed(delay, [this, generation]() { runTimer(generation); }, kStrandKey);
+    armedFor_ = due;
+}
+
+} // namespace application
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ReadResult.h"
+#include "TaskScheduler.h"
+
+namespace application {
+
+enum class DeadbandMode { Absolute, Percent };
+
+struct SubscriptionConfig {
+    std::uint8_t slaveId = 1;
+    protocol::FunctionCode function = protocol::FunctionCode::ReadHoldingRegisters;  // selects the table
+    std::uint16_t address = 0;
+    std::uint16_t count = 1;
+    // A register is reported once it moves further than this from its last reported value; Percent is
+    // relative to that value. Zero reports every change.
+    DeadbandMode deadbandMode = DeadbandMode::Absolute;
+    double deadband = 0.0;
+    std::chrono::milliseconds minInterval{0};  // changes within this after a report are held and merged
+    std::chrono::milliseconds maxInterval{0};  // without changes, every known register is re-reported this often; 0 never
+};
+
+struct RegisterDelta {
+    std::uint16_t address = 0;
+    std::uint16_t value = 0;
+};
+
+// What one subscription reports: only the registers that left their deadband, or all of them on a heartbeat.
+struct ChangeReport {
+    std::uint64_t subscriptionId = 0;
+    std::uint8_t slaveId = 0;
+    protocol::FunctionCode function = protocol::FunctionCode::ReadHoldingRegisters;
+    bool heartbeat = false;
+    std::vector<RegisterDelta> changes;
+    std::chrono::system_clock::time_point timestamp;
+};
+
+struct SubscriptionStats {
+    std::uint64_t subscriptions = 0;
+    std::uint64_t registers = 0;          // monitored registers over all subscriptions
+    std::uint64_t samples = 0;            // register blocks compared against a subscription
+    std::uint64_t registersCompared = 0;
+    std::uint64_t reports = 0;
+    std::uint64_t registersReported = 0;
+    std::uint64_t heartbeats = 0;
+};
+
+// Change detection over the register values coming off the wire. Each subscription keeps the last
+// reported value of its registers and a per-register threshold, and every incoming block is compared
+// against them in one branch-free pass; only registers outside their deadband reach the sinks.
+// Held changes, heartbeats and sink calls run on the scheduler, so the owner must join it before
+// destroying the engine.
+class SubscriptionEngine {
+public:
+    using Sink = std::function<void(const ChangeReport&)>;
+    using SinkId = std::uint64_t;
+
+    explicit SubscriptionEngine(TaskScheduler& scheduler);
+    ~SubscriptionEngine();
+
+    SubscriptionEngine(const SubscriptionEngine&) = delete;
+    SubscriptionEngine& operator=(const SubscriptionEngine&) = delete;
+
+    bool add(const SubscriptionConfig& config, std::uint64_t& id, std::string& error);
+    bool remove(std::uint64_t id);
+
+    // Sinks see the reports of every subscription in the order they were made, on a scheduler worker.
+    // They must not block or add/remove sinks; removeSink returns once no call is in progress.
+    SinkId addSink(Sink sink);
+    void removeSink(SinkId id);
+
+    // Feeds values seen on the wire; cheap when no subscription covers them.
+    void ingest(const ReadResult& update);
+    bool active() const noexcept { return active_.load(); }
+
+    SubscriptionStats stats() const;
+    void stop();
+
+    static constexpr TaskScheduler::StrandKey kStrandKey = std::numeric_limits<TaskScheduler::StrandKey>::max() - 1;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Subscription {
+        std::uint64_t id = 0;
+        SubscriptionConfig config;
+        std::vector<std::uint16_t> current;    // latest value seen
+        std::vector<std::uint16_t> reference;  // last reported value
+        std::vector<std::int32_t> threshold;   // report when |current - reference| exceeds it
+        bool held = false;                     // a change is waiting for minInterval to pass
+        Clock::time_point lastReport;
+    };
+
+    // Subscriptions of one (slave, table), sorted by start address so a block only visits the
+    // subscriptions it overlaps.
+    struct DeviceIndex {
+        std::vector<Subscription*> byAddress;
+        std::uint32_t widest = 0;  // longest range, bounds how far back an overlapping start can lie
+    };
+
+    // slave << 8 | table
+    static std::uint32_t deviceKey(std::uint8_t slaveId, protocol::FunctionCode function) noexcept;
+    static std::int32_t thresholdFor(const SubscriptionConfig& config, std::uint16_t reference) noexcept;
+    ChangeReport reportLocked(Subscription& subscription, bool heartbeat, Clock::time_point now);
+    // Queued on the engine's strand while the lock is held, so reports reach the sinks in the order they
+    // were made and no sink runs under the engine lock.
+    void publishLocked(std::vector<ChangeReport> reports);
+    void runTimer(std::uint64_t generation);
+    void armLocked(Clock::time_point due);
+
+    TaskScheduler& scheduler_;
+
+    mutable std::mutex mutex_;
+    std::map<std::uint64_t, Subscription> subscriptions_;
+    std::unordered_map<std::uint32_t, DeviceIndex> byDevice_;
+    std::uint64_t nextId_ = 1;
+    std::atomic<bool> active_{false};
+    bool stopped_ = false;
+    SubscriptionStats stats_;
+
+    TaskScheduler::TaskId timerId_ = 0;
+    std::uint64_t generation_ = 0;
+    std::optional<Clock::time_point> armedFor_;
+
+    std::mutex sinksMutex_;
+    std::map<SinkId, Sink> sinks_;
+    SinkId nextSinkId_ = 1;
+};
+
+} // namespace application
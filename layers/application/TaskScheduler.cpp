@@ -0,0 +1,192 @@
+#include "TaskScheduler.h"
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+
+namespace application {
+
+TaskScheduler::TaskScheduler(std::size_t workers)
+    : workers_(std::max<std::size_t>(workers, 1)), pool_(workers_) {}
+
+TaskScheduler::~TaskScheduler() {
+    stop();
+}
+
+bool TaskScheduler::post(Task task) {
+    if (stopped_) {
+        return false;
+    }
+    boost::asio::post(pool_, wrap(std::move(task)));
+    return true;
+}
+
+bool TaskScheduler::post(StrandKey key, Task task) {
+    if (stopped_) {
+        return false;
+    }
+    boost::asio::post(strandFor(key), wrap(std::move(task)));
+    return true;
+}
+
+TaskScheduler::TaskId TaskScheduler::postDelayed(std::chrono::milliseconds delay, Task task, std::optional<StrandKey> key) {
+    return arm(delay, std::move(task), std::chrono::milliseconds::zero(), key);
+}
+
+TaskScheduler::TaskId TaskScheduler::postPeriodic(std::chrono::milliseconds period, Task task, std::optional<StrandKey> key) {
+    return arm(period, std::move(task), std::max(period, std::chrono::milliseconds(1)), key);
+}
+
+bool TaskScheduler::cancel(TaskId id) {
+    std::shared_ptr<TimerEntry> entry;
+    {
+        std::lock_guard<std::mutex> lock(timersMutex_);
+        const auto it = timers_.find(id);
+        if (it == timers_.end()) {
+            return false;
+        }
+        entry = std::move(it->second);
+        timers_.erase(it);
+    }
+    boost::asio::post(entry->timer.get_executor(), [entry]() { entry->timer.cancel(); });
+    return true;
+}
+
+void TaskScheduler::releaseStrand(StrandKey key) {
+    std::lock_guard<std::mutex> lock(strandsMutex_);
+    strands_.erase(key);
+}
+
+void TaskScheduler::stop() {
+    if (stopped_.exchange(true)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(timersMutex_);
+        for (auto& [_, entry] : timers_) {
+            boost::asio::post(entry->timer.get_executor(), [entry = entry]() { entry->timer.cancel(); });
+        }
+        timers_.clear();
+    }
+    pool_.join();
+}
+
+SchedulerStats TaskScheduler::stats() const {
+    SchedulerStats stats;
+    stats.workers = workers_;
+    stats.queued = queued_.load();
+    stats.maxQueued = maxQueued_.load();
+    stats.running = running_.load();
+    stats.executed = executed_.load();
+    stats.failed = failed_.load();
+    stats.overruns = overruns_.load();
+    {
+        std::lock_guard<std::mutex> lock(timersMutex_);
+        stats.timers = timers_.size();
+    }
+    return stats;
+}
+
+TaskScheduler::TaskId TaskScheduler::arm(std::chrono::milliseconds delay, Task task, std::chrono::milliseconds period,
+                                         std::optional<StrandKey> key) {
+    if (stopped_) {
+        return 0;
+    }
+
+    const TaskId id = nextTaskId_.fetch_add(1);
+    // Each timer gets its own strand so cancel() never races the re-arm in fire().
+    auto entry = std::make_shared<TimerEntry>(boost::asio::make_strand(pool_.get_executor()), std::move(task), period, key);
+    entry->timer.expires_after(delay);
+    {
+        // stop() may have cleared timers_ since the check above; a timer inserted now would never be
+        // cancelled and would hold up pool_.join() until it expired.
+        std::lock_guard<std::mutex> lock(timersMutex_);
+        if (stopped_) {
+            return 0;
+        }
+        timers_[id] = entry;
+    }
+    boost::asio::post(entry->timer.get_executor(), [this, id, entry]() { wait(id, entry); });
+    return id;
+}
+
+void TaskScheduler::wait(TaskId id, const std::shared_ptr<TimerEntry>& entry) {
+    entry->timer.async_wait([this, id, entry](const boost::system::error_code& ec) {
+        if (ec || stopped_) {
+            return;
+        }
+        fire(id, entry);
+    });
+}
+
+void TaskScheduler::fire(TaskId id, const std::shared_ptr<TimerEntry>& entry) {
+    const bool periodic = entry->period.count() > 0;
+    {
+        std::lock_guard<std::mutex> lock(timersMutex_);
+        if (timers_.find(id) == timers_.end()) {
+            return;  // cancelled between expiry and this handler
+        }
+        if (!periodic) {
+            timers_.erase(id);
+        }
+    }
+
+    if (!periodic) {
+        entry->key ? post(*entry->key, entry->task) : post(entry->task);
+        return;
+    }
+
+    if (entry->busy.exchange(true)) {
+        ++overruns_;
+    } else {
+        Task run = [entry]() {
+            struct BusyReset {
+                std::atomic<bool>& busy;
+                ~BusyReset() { busy = false; }
+            } reset{entry->busy};
+            entry->task();
+        };
+        entry->key ? post(*entry->key, std::move(run)) : post(std::move(run));
+    }
+
+    // Fixed rate without catch-up bursts: if we fell behind, resume one period from now.
+    const auto now = boost::asio::steady_timer::clock_type::now();
+    auto next = entry->timer.expiry() + entry->period;
+    if (next <= now) {
+        next = now + entry->period;
+    }
+    entry->timer.expires_at(next);
+    wait(id, entry);
+}
+
+TaskScheduler::Strand TaskScheduler::strandFor(StrandKey key) {
+    std::lock_guard<std::mutex> lock(strandsMutex_);
+    auto it = strands_.find(key);
+    if (it == strands_.end()) {
+        it = strands_.emplace(key, boost::asio::make_strand(pool_.get_executor())).first;
+    }
+    return it->second;
+}
+
+TaskScheduler::Task TaskScheduler::wrap(Task task) {
+    const auto depth = ++queued_;
+    auto seen = maxQueued_.load();
+    while (depth > seen && !maxQueued_.compare_exchange_weak(seen, depth)) {
+    }
+
+    return [this, task = std::move(task)]() {
+        --queued_;
+        ++running_;
+        try {
+            task();
+        } catch (...) {
+            // A failing task must not take a pool thread down with it.
+            ++failed_;
+        }
+        --running_;
+        ++executed_;
+    };
+}
+
+} // namespace application
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace application {
+
+struct SchedulerStats {
+    std::size_t workers = 0;
+    std::uint64_t queued = 0;       // posted, not yet started
+    std::uint64_t maxQueued = 0;    // high-water mark of `queued`
+    std::uint64_t running = 0;
+    std::uint64_t executed = 0;
+    std::uint64_t failed = 0;       // tasks that ended with an exception
+    std::uint64_t timers = 0;       // armed delayed/periodic tasks
+    std::uint64_t overruns = 0;     // periodic ticks skipped because the previous run was still busy
+};
+
+// Worker pool for application work. Tasks posted with the same strand key (a device or a session)
+// run one at a time in posting order; everything else runs on any free worker.
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+    using TaskId = std::uint64_t;
+    using StrandKey = std::uint64_t;
+    using Executor = boost::asio::thread_pool::executor_type;
+
+    explicit TaskScheduler(std::size_t workers = kDefaultWorkers);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Return false once the scheduler is stopped; the task is then dropped.
+    bool post(Task task);
+    bool post(StrandKey key, Task task);
+
+    TaskId postDelayed(std::chrono::milliseconds delay, Task task, std::optional<StrandKey> key = std::nullopt);
+    // Fixed-rate: ticks that fall due while the previous run is still queued or running are skipped.
+    TaskId postPeriodic(std::chrono::milliseconds period, Task task, std::optional<StrandKey> key = std::nullopt);
+    bool cancel(TaskId id);
+
+    // Drops the strand of a key that will not be used again (e.g. a closed session).
+    void releaseStrand(StrandKey key);
+
+    void stop();
+    SchedulerStats stats() const;
+
+    // For work that schedules itself, such as coroutines; it bypasses the counters above.
+    Executor executor() noexcept { return pool_.get_executor(); }
+
+    static constexpr std::size_t kDefaultWorkers = 4;
+
+private:
+    using Strand = boost::asio::strand<Executor>;
+
+    struct TimerEntry {
+        TimerEntry(Strand executor, Task t, std::chrono::milliseconds p, std::optional<StrandKey> k)
+            : timer(executor), task(std::move(t)), period(p), key(k) {}
+
+        boost::asio::steady_timer timer;
+        Task task;
+        std::chrono::milliseconds period;  // zero for one-shot tasks
+        std::optional<StrandKey> key;
+        std::atomic<bool> busy{false};
+    };
+
+    TaskId arm(std::chrono::milliseconds delay, Task task, std::chrono::milliseconds period, std::optional<StrandKey> key);
+    void wait(TaskId id, const std::shared_ptr<TimerEntry>& entry);
+    void fire(TaskId id, const std::shared_ptr<TimerEntry>& entry);
+    Strand strandFor(StrandKey key);
+    Task wrap(Task task);
+
+    std::size_t workers_;
+    boost::asio::thread_pool pool_;
+    std::atomic<bool> stopped_{false};
+
+    std::mutex strandsMutex_;
+    std::unordered_map<StrandKey, Strand> strands_;
+
+    mutable std::mutex timersMutex_;
+    std::unordered_map<TaskId, std::shared_ptr<TimerEntry>> timers_;
+    std::atomic<TaskId> nextTaskId_{1};
+
+    std::atomic<std::uint64_t> queued_{0};
+    std::atomic<std::uint64_t> maxQueued_{0};
+    std::atomic<std::uint64_t> running_{0};
+    std::atomic<std::uint64_t> executed_{0};
+    std::atomic<std::uint64_t> failed_{0};
+    std::atomic<std::uint64_t> overruns_{0};
+};
+
+} // namespace application
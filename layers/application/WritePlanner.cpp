@@ -0,0 +1,94 @@
+#include "WritePlanner.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace application {
+
+namespace {
+
+struct RegisterWrite {
+    std::uint16_t value = 0;
+    std::size_t item = 0;
+};
+
+bool mergeable(const protocol::ModbusRequest& item) {
+    switch (item.function) {
+        case protocol::FunctionCode::WriteSingleRegister:
+            return item.values.size() == 1;
+        case protocol::FunctionCode::WriteMultipleRegisters:
+            return !item.values.empty() && item.values.size() <= protocol::kMaxWriteRegisters &&
+                   item.startAddress + item.values.size() <= 0x10000;
+        default:
+            return false;
+    }
+}
+
+void appendUnique(std::vector<std::size_t>& items, std::size_t index) {
+    if (std::find(items.begin(), items.end(), index) == items.end()) {
+        items.push_back(index);
+    }
+}
+
+} // namespace
+
+std::vector<PlannedWrite> WritePlanner::plan(const std::vector<protocol::ModbusRequest>& items) {
+    std::vector<PlannedWrite> planned;
+
+    // Final register image per slave: later items overwrite earlier ones.
+    std::map<std::uint8_t, std::map<std::uint16_t, RegisterWrite>> images;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const auto& item = items[i];
+        if (!mergeable(item)) {
+            planned.push_back(PlannedWrite{item, {i}});
+            continue;
+        }
+        auto& image = images[item.slaveId];
+        for (std::size_t k = 0; k < item.values.size(); ++k) {
+            image[static_cast<std::uint16_t>(item.startAddress + k)] = RegisterWrite{item.values[k], i};
+        }
+    }
+
+    auto flush = [&](std::uint8_t slaveId, std::map<std::uint16_t, RegisterWrite>::const_iterator first,
+                     std::map<std::uint16_t, RegisterWrite>::const_iterator last) {
+        PlannedWrite write;
+        write.request.slaveId = slaveId;
+        write.request.startAddress = first->first;
+        for (auto it = first; it != last; ++it) {
+            write.request.values.push_back(it->second.value);
+            appendUnique(write.items, it->second.item);
+        }
+        write.request.count = static_cast<std::uint16_t>(write.request.values.size());
+        write.request.function = write.request.values.size() == 1 ? items[first->second.item].function
+                                                                  : protocol::FunctionCode::WriteMultipleRegisters;
+        std::sort(write.items.begin(), write.items.end());
+        planned.push_back(std::move(write));
+    };
+
+    for (const auto& [slaveId, image] : images) {
+        auto runStart = image.begin();
+        std::size_t runLength = 0;
+        std::uint32_t expected = 0;
+        for (auto it = image.begin(); it != image.end(); ++it) {
+            if (runLength > 0 && (it->first != expected || runLength == protocol::kMaxWriteRegisters)) {
+                flush(slaveId, runStart, it);
+                runStart = it;
+                runLength = 0;
+            }
+            expected = static_cast<std::uint32_t>(it->first) + 1;
+            ++runLength;
+        }
+        if (runLength > 0) {
+            flush(slaveId, runStart, image.end());
+        }
+    }
+
+    // Send frames in the order their earliest contributing item was submitted.
+    std::stable_sort(planned.begin(), planned.end(), [](const PlannedWrite& a, const PlannedWrite& b) {
+        return a.items.front() < b.items.front();
+    });
+    return planned;
+}
+
+} // namespace application
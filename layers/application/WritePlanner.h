@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "layers/protocol/protocol_layer.h"
+
+namespace application {
+
+// One write frame as it goes on the wire, plus the caller's items that contributed to it.
+struct PlannedWrite {
+    protocol::ModbusRequest request;
+    std::vector<std::size_t> items;  // indices into the list passed to WritePlanner::plan
+};
+
+// Merges FC06/FC16 writes of the same slave into maximal FC16 frames (at most 123 registers).
+// Overlapping registers resolve last-writer-wins in submission order; a register that ends up
+// alone keeps the function of the item that wrote it last.
+class WritePlanner {
+public:
+    static std::vector<PlannedWrite> plan(const std::vector<protocol::ModbusRequest>& items);
+};
+
+} // namespace application
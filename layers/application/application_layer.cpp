@@ -1,8 +1,10 @@
 #include "application_layer.h"
 
 #include <algorithm>
-#include <filesystem>
+#include <array>
 #include <chrono>
+#include <filesystem>
+#include <iterator>
 #include <utility>
 
 #ifdef _WIN32
@@ -14,39 +16,86 @@ namespace application {
 namespace json = boost::json;
 
 namespace {
-bool isReadFunctionString(const std::string& fn) {
-    return fn == "read_holding" || fn == "read_input";
+
+// Grace period past a blocking caller's timeout before it reaps expired requests itself.
+constexpr std::chrono::milliseconds kReaperSlack{20};
+
+bool isWriteFunction(protocol::FunctionCode function) noexcept {
+    return function == protocol::FunctionCode::WriteSingleRegister || function == protocol::FunctionCode::WriteMultipleRegisters;
+}
+
+bool overlaps(const protocol::ModbusRequest& request, std::uint8_t slaveId, std::uint16_t address, std::size_t count) {
+    const std::size_t length = isWriteFunction(request.function) ? request.values.size() : request.count;
+    return request.slaveId == slaveId && request.startAddress < address + count && address < request.startAddress + length;
 }
+
+ReadOutcome cachedOutcome(const protocol::ModbusRequest& request, const std::uint16_t* values) {
+    ReadOutcome outcome;
+    outcome.ok = true;
+    outcome.result.slaveId = request.slaveId;
+    outcome.result.function = request.function;
+    outcome.result.address = request.startAddress;
+    outcome.result.count = request.count;
+    for (std::size_t i = 0; i < request.count; ++i) {
+        outcome.result.values.push_back(values[i]);
+    }
+    return outcome;
 }
 
-ApplicationCore::ApplicationCore(transport::TransportManager& transportManager)
-    : transportManager_(transportManager) {
+} // namespace
+
+ApplicationCore::ApplicationCore(transport::TransportManager& transportManager, std::size_t workerThreads)
+    : transportManager_(transportManager),
+      taskScheduler_(workerThreads),
+      pollingEngine_(taskScheduler_, readPlanner_,
+                     [this](const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs,
+                            EachCallback onDone) { readEachAsync(requests, timeoutMs, std::move(onDone)); }),
+      subscriptionEngine_(taskScheduler_) {
     transportManager_.setFrameCallback(
-        [this](const std::vector<std::uint8_t>& frame, const transport::SessionPtr& session) {
+        [this](transport::ByteSpan frame, const transport::SessionPtr& session) {
             onTransportFrame(frame, session);
         });
 
+    transportManager_.setSessionContextFactory([this](const transport::Session& session) {
+        return std::unique_ptr<transport::SessionContext>(protocolHandler_.createDecoder(session.connectionType()));
+    });
+
+    // Pages nobody has refreshed within the TTL would never be served again; drop them.
+    taskScheduler_.postPeriodic(RegisterCache::kDefaultTtl, [this]() { registerCache_.prune(); });
+
     transportManager_.setConnectionCallback([this](bool connected, const transport::SessionPtr& session) {
         if (!connected && session) {
             deviceManager_.unbindSessionById(session->id());
+            taskScheduler_.releaseStrand(session->id());
             std::lock_guard<std::mutex> lock(transportConfigMutex_);
             transportConfig_.active = false;
         }
     });
 }
 
+ApplicationCore::~ApplicationCore() {
+    // Joins every scheduler worker, so no task outlives the members it uses.
+    pollingEngine_.stop();
+    subscriptionEngine_.stop();
+    taskScheduler_.stop();
+}
+
 void ApplicationCore::setJsonResponseCallback(std::function<void(const json::value&)> cb) {
     jsonResponseCallback_ = std::move(cb);
 }
 
-bool ApplicationCore::openTcpTransport(const std::string& host, std::uint16_t port, std::string& error) {
-    auto session = transportManager_.connectTcpSlave(host, port);
+bool ApplicationCore::openTcpTransport(const std::string& host, std::uint16_t port, std::string& error,
+                                       std::uint32_t connectTimeoutMs) {
+    std::string connectError;
+    auto session = transportManager_.connectTcpSlave(host, port, std::chrono::milliseconds(connectTimeoutMs), &connectError);
     if (!session) {
-        error = "Failed to open TCP transport";
+        error = "Failed to open TCP transport: " + connectError;
         return false;
     }
 
     deviceManager_.bindSession("default", 1, session);
+    registerCache_.clear();
+    readPlanner_.configureLink(ReadPlanner::kTcpRegisterCostUs, ReadPlanner::kTcpRequestOverheadUs);
 
     std::lock_guard<std::mutex> lock(transportConfigMutex_);
     transportConfig_.type = transport::ConnectionType::Tcp;
@@ -55,18 +104,28 @@ bool ApplicationCore::openTcpTransport(const std::string& host, std::uint16_t po
     transportConfig_.serialPort.clear();
     transportConfig_.baudRate = 0;
     transportConfig_.stopBits = 0;
+    transportConfig_.connectTimeoutMs = connectTimeoutMs;
     transportConfig_.active = true;
     return true;
 }
 
-bool ApplicationCore::openRtuTransport(const std::string& serialPort, std::uint32_t baudRate, std::uint8_t stopBits, std::string& error) {
-    auto session = transportManager_.connectSerialSlave(serialPort, baudRate);
+bool ApplicationCore::openRtuTransport(const std::string& serialPort, std::uint32_t baudRate, std::uint8_t stopBits, std::string& error,
+                                       std::uint32_t connectTimeoutMs) {
+    std::string connectError;
+    auto session = transportManager_.connectSerialSlave(serialPort, baudRate, std::chrono::milliseconds(connectTimeoutMs), &connectError);
     if (!session) {
-        error = "Failed to open RTU transport";
+        error = "Failed to open RTU transport: " + connectError;
         return false;
     }
 
     deviceManager_.bindSession("default", 1, session);
+    registerCache_.clear();
+
+    // One character is start + 8 data + stop bits; a register is two characters. Until the first
+    // round trip is measured, charge each exchange for an 8-byte request, a 5-byte response
+    // header/CRC and two 3.5-character silent intervals.
+    const double charUs = (9.0 + stopBits) * 1e6 / std::max<std::uint32_t>(baudRate, 1);
+    readPlanner_.configureLink(2.0 * charUs, 20.0 * charUs);
 
     std::lock_guard<std::mutex> lock(transportConfigMutex_);
     transportConfig_.type = transport::ConnectionType::Rtu;
@@ -75,6 +134,7 @@ bool ApplicationCore::openRtuTransport(const std::string& serialPort, std::uint3
     transportConfig_.serialPort = serialPort;
     transportConfig_.baudRate = baudRate;
     transportConfig_.stopBits = stopBits;
+    transportConfig_.connectTimeoutMs = connectTimeoutMs;
     transportConfig_.active = true;
     return true;
 }
@@ -111,9 +171,9 @@ bool ApplicationCore::switchTransport(const TransportConfig& target, std::string
     closeActiveTransport(closedInfo);
 
     if (target.type == transport::ConnectionType::Tcp) {
-        return openTcpTransport(target.host, target.port, error);
+        return openTcpTransport(target.host, target.port, error, target.connectTimeoutMs);
     }
-    return openRtuTransport(target.serialPort, target.baudRate, target.stopBits, error);
+    return openRtuTransport(target.serialPort, target.baudRate, target.stopBits, error, target.connectTimeoutMs);
 }
 
 TransportConfig ApplicationCore::transportStatus() const {
@@ -121,6 +181,14 @@ TransportConfig ApplicationCore::transportStatus() const {
     return transportConfig_;
 }
 
+std::vector<transport::SessionStats> ApplicationCore::sessionStats() const {
+    std::vector<transport::SessionStats> stats;
+    for (const auto& session : transportManager_.getAllConnections()) {
+        stats.push_back(session->stats());
+    }
+    return stats;
+}
+
 std::vector<std::string> ApplicationCore::listSerialPorts() const {
     std::vector<std::string> ports;
 #ifdef _WIN32
@@ -157,6 +225,158 @@ std::vector<std::string> ApplicationCore::listSerialPorts() const {
     return ports;
 }
 
+void ApplicationCore::readAsync(const protocol::ModbusRequest& request, std::uint32_t timeoutMs, ReadCallback onDone,
+                                std::uint32_t maxAgeMs, CancelToken cancelToken) {
+    if (!protocol::isReadFunction(request.function)) {
+        onDone(ReadOutcome{false, "readAsync supports read functions only", {}});
+        return;
+    }
+    if (static_cast<std::uint32_t>(request.startAddress) + request.count > 0x10000) {
+        onDone(ReadOutcome{false, "Register range is out of bounds", {}});
+        return;
+    }
+    if (maxAgeMs == 0 || request.count == 0 || request.count > protocol::kMaxReadRegisters) {
+        submit(request, timeoutMs, std::move(onDone), nullptr, cancelToken);
+        return;
+    }
+
+    auto values = std::make_shared<std::array<std::uint16_t, protocol::kMaxReadRegisters>>();
+    const auto missing = registerCache_.lookup(request.slaveId, request.function, request.startAddress, request.count,
+                                               std::chrono::milliseconds(maxAgeMs), values->data());
+    if (missing.empty()) {
+        onDone(cachedOutcome(request, values->data()));
+        return;
+    }
+
+    std::vector<protocol::ModbusRequest> fetch;
+    fetch.reserve(missing.size());
+    for (const auto& range : missing) {
+        protocol::ModbusRequest part = request;
+        part.startAddress = range.address;
+        part.count = range.count;
+        fetch.push_back(part);
+    }
+    groupAsync(fetch, timeoutMs, true, [request, values, onDone = std::move(onDone)](GroupOutcome group) {
+        if (!group.ok) {
+            onDone(ReadOutcome{false, std::move(group.error), {}, group.exceptionCode});
+            return;
+        }
+        for (const auto& part : group.results) {
+            for (std::size_t i = 0; i < part.values.size(); ++i) {
+                (*values)[part.address - request.startAddress + i] = part.values[i];
+            }
+        }
+        onDone(cachedOutcome(request, values->data()));
+    }, cancelToken);
+}
+
+void ApplicationCore::writeAsync(const protocol::ModbusRequest& request, std::uint32_t timeoutMs, WriteCallback onDone,
+                                 CancelToken cancelToken) {
+    if (!isWriteFunction(request.function)) {
+        onDone(WriteOutcome{false, "writeAsync supports write functions only"});
+        return;
+    }
+    submit(request, timeoutMs, nullptr, std::move(onDone), cancelToken);
+}
+
+void ApplicationCore::groupAsync(const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs, bool coalesce,
+                                 GroupCallback onDone, CancelToken cancelToken) {
+    std::vector<PlannedRead> planned;
+    if (coalesce) {
+        planned = readPlanner_.plan(requests);
+    } else {
+        planned.reserve(requests.size());
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            planned.push_back(PlannedRead{requests[i], {i}});
+        }
+    }
+    if (planned.empty()) {
+        onDone(GroupOutcome{true, {}, {}});
+        return;
+    }
+
+    struct GroupState {
+        std::mutex mutex;
+        std::vector<protocol::ModbusRequest> requests;
+        GroupOutcome outcome;
+        std::size_t remaining = 0;
+        bool done = false;
+        GroupCallback onDone;
+    };
+    auto state = std::make_shared<GroupState>();
+    state->requests = requests;
+    state->outcome.results.resize(requests.size());
+    state->remaining = planned.size();
+    state->onDone = std::move(onDone);
+
+    // Everything is submitted at once; frames beyond the in-flight window queue per session, so on
+    // Modbus/TCP up to maxInFlight() of them share a single round trip.
+    for (auto& read : planned) {
+        submit(read.request, timeoutMs, [state, items = std::move(read.items)](ReadOutcome outcome) {
+            GroupCallback onDone;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->done) {
+                    return;
+                }
+                if (outcome.ok) {
+                    for (const auto index : items) {
+                        if (!ReadPlanner::extract(outcome.result, state->requests[index], state->outcome.results[index])) {
+                            outcome.ok = false;
+                            outcome.error = "Short Modbus read response";
+                            break;
+                        }
+                    }
+                }
+                if (outcome.ok && --state->remaining != 0) {
+                    return;
+                }
+                state->done = true;
+                state->outcome.ok = outcome.ok;
+                if (!outcome.ok) {
+                    state->outcome.error = std::move(outcome.error);
+                    state->outcome.exceptionCode = outcome.exceptionCode;
+                    state->outcome.results.clear();
+                }
+                onDone = std::move(state->onDone);
+            }
+            onDone(std::move(state->outcome));
+        }, nullptr, cancelToken);
+    }
+}
+
+void ApplicationCore::readEachAsync(const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs,
+                                    EachCallback onDone) {
+    if (requests.empty()) {
+        onDone({});
+        return;
+    }
+
+    struct EachState {
+        std::mutex mutex;
+        std::vector<ReadOutcome> outcomes;
+        std::size_t remaining = 0;
+        EachCallback onDone;
+    };
+    auto state = std::make_shared<EachState>();
+    state->outcomes.resize(requests.size());
+    state->remaining = requests.size();
+    state->onDone = std::move(onDone);
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        readAsync(requests[i], timeoutMs, [state, i](ReadOutcome outcome) {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->outcomes[i] = std::move(outcome);
+                if (--state->remaining != 0) {
+                    return;
+                }
+            }
+            state->onDone(std::move(state->outcomes));
+        });
+    }
+}
+
 bool ApplicationCore::readRegisters(std::uint8_t slaveId, std::uint16_t address, std::uint16_t count, bool input, std::string& error) {
     protocol::ModbusRequest request;
     request.slaveId = slaveId;
@@ -166,26 +386,56 @@ bool ApplicationCore::readRegisters(std::uint8_t slaveId, std::uint16_t address,
     return sendCommand(request, error);
 }
 
+bool ApplicationCore::readGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error) {
+    for (const auto& request : requests) {
+        if (!sendCommand(request, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool ApplicationCore::readRegistersDetailed(std::uint8_t slaveId, std::uint16_t address, std::uint16_t count, bool input,
-                                           json::object& result, std::string& error, std::uint32_t timeoutMs) {
+                                           ReadResult& result, std::string& error, std::uint32_t timeoutMs,
+                                           std::uint32_t maxAgeMs) {
     protocol::ModbusRequest request;
     request.slaveId = slaveId;
     request.function = input ? protocol::FunctionCode::ReadInputRegisters : protocol::FunctionCode::ReadHoldingRegisters;
     request.startAddress = address;
     request.count = count;
-    return sendReadAndWait(request, result, error, timeoutMs);
+
+    auto done = std::make_shared<std::promise<ReadOutcome>>();
+    auto future = done->get_future();
+    readAsync(request, timeoutMs, [done](ReadOutcome outcome) { done->set_value(std::move(outcome)); }, maxAgeMs);
+    auto outcome = waitFor(future, timeoutMs);
+    if (!outcome.ok) {
+        error = std::move(outcome.error);
+        return false;
+    }
+    result = std::move(outcome.result);
+    return true;
 }
 
-bool ApplicationCore::writeSingleRegister(std::uint8_t slaveId, std::uint16_t address, std::uint16_t value, std::string& error) {
+bool ApplicationCore::writeSingleRegister(std::uint8_t slaveId, std::uint16_t address, std::uint16_t value, std::string& error,
+                                          std::uint32_t timeoutMs) {
     protocol::ModbusRequest request;
     request.slaveId = slaveId;
     request.function = protocol::FunctionCode::WriteSingleRegister;
     request.startAddress = address;
     request.values = {value};
-    return sendCommand(request, error);
+
+    auto done = std::make_shared<std::promise<WriteOutcome>>();
+    auto future = done->get_future();
+    writeAsync(request, timeoutMs, [done](WriteOutcome outcome) { done->set_value(std::move(outcome)); });
+    auto outcome = waitFor(future, timeoutMs);
+    if (!outcome.ok) {
+        error = std::move(outcome.error);
+    }
+    return outcome.ok;
 }
 
-bool ApplicationCore::writeMultipleRegisters(std::uint8_t slaveId, std::uint16_t address, const std::vector<std::uint16_t>& values, std::string& error) {
+bool ApplicationCore::writeMultipleRegisters(std::uint8_t slaveId, std::uint16_t address, const std::vector<std::uint16_t>& values,
+                                             std::string& error, std::uint32_t timeoutMs) {
     if (values.empty()) {
         error = "Values are empty";
         return false;
@@ -197,37 +447,92 @@ bool ApplicationCore::writeMultipleRegisters(std::uint8_t slaveId, std::uint16_t
     request.startAddress = address;
     request.count = static_cast<std::uint16_t>(values.size());
     request.values = values;
-    return sendCommand(request, error);
+
+    auto done = std::make_shared<std::promise<WriteOutcome>>();
+    auto future = done->get_future();
+    writeAsync(request, timeoutMs, [done](WriteOutcome outcome) { done->set_value(std::move(outcome)); });
+    auto outcome = waitFor(future, timeoutMs);
+    if (!outcome.ok) {
+        error = std::move(outcome.error);
+    }
+    return outcome.ok;
 }
 
-bool ApplicationCore::readGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error) {
-    for (const auto& request : requests) {
-        if (!sendCommand(request, error)) {
-            return false;
-        }
+bool ApplicationCore::readGroupDetailed(const std::vector<protocol::ModbusRequest>& requests, std::vector<ReadResult>& results,
+                                        std::string& error, std::uint32_t timeoutMs, bool coalesce) {
+    auto done = std::make_shared<std::promise<GroupOutcome>>();
+    auto future = done->get_future();
+    groupAsync(requests, timeoutMs, coalesce, [done](GroupOutcome outcome) { done->set_value(std::move(outcome)); });
+    auto outcome = waitFor(future, timeoutMs);
+    if (!outcome.ok) {
+        error = std::move(outcome.error);
+        return false;
     }
+    results.insert(results.end(), std::make_move_iterator(outcome.results.begin()),
+                   std::make_move_iterator(outcome.results.end()));
     return true;
 }
 
-bool ApplicationCore::readGroupDetailed(const std::vector<protocol::ModbusRequest>& requests, json::array& results,
-                                        std::string& error, std::uint32_t timeoutMs) {
-    for (const auto& request : requests) {
-        json::object single;
-        if (!sendReadAndWait(request, single, error, timeoutMs)) {
-            return false;
+std::vector<ReadOutcome> ApplicationCore::readEach(const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs) {
+    auto done = std::make_shared<std::promise<std::vector<ReadOutcome>>>();
+    auto future = done->get_future();
+    readEachAsync(requests, timeoutMs, [done](std::vector<ReadOutcome> outcomes) { done->set_value(std::move(outcomes)); });
+    return waitFor(future, timeoutMs);
+}
+
+bool ApplicationCore::writeGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error, bool coalesce,
+                                 std::size_t* framesSent, std::uint32_t timeoutMs) {
+    const auto planned = planWriteGroup(requests, coalesce);
+    std::vector<std::future<WriteOutcome>> futures;
+    futures.reserve(planned.size());
+    for (const auto& write : planned) {
+        auto done = std::make_shared<std::promise<WriteOutcome>>();
+        futures.push_back(done->get_future());
+        writeAsync(write.request, timeoutMs, [done](WriteOutcome outcome) { done->set_value(std::move(outcome)); });
+    }
+
+    bool ok = true;
+    for (auto& future : futures) {
+        auto outcome = waitFor(future, timeoutMs);
+        if (!outcome.ok && ok) {
+            ok = false;
+            error = std::move(outcome.error);
         }
-        results.emplace_back(single);
     }
-    return true;
+    if (ok && framesSent) {
+        *framesSent = planned.size();
+    }
+    return ok;
 }
 
-bool ApplicationCore::writeGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error) {
-    for (const auto& request : requests) {
-        if (!sendCommand(request, error)) {
-            return false;
+std::vector<PlannedWrite> ApplicationCore::planWriteGroup(const std::vector<protocol::ModbusRequest>& requests, bool coalesce) const {
+    if (coalesce) {
+        return WritePlanner::plan(requests);
+    }
+
+    std::vector<PlannedWrite> planned;
+    planned.reserve(requests.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        planned.push_back(PlannedWrite{requests[i], {i}});
+    }
+    return planned;
+}
+
+void ApplicationCore::setMaxInFlight(std::size_t window) {
+    maxInFlight_ = std::clamp<std::size_t>(window, 1, kMaxInFlightLimit);
+
+    Deferred deferred;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        std::vector<std::uint64_t> sessions;
+        for (const auto& [sessionId, _] : waiting_) {
+            sessions.push_back(sessionId);
+        }
+        for (const auto sessionId : sessions) {
+            pumpLocked(sessionId, deferred);
         }
     }
-    return true;
+    runDeferred(deferred);
 }
 
 bool ApplicationCore::sendCommand(const protocol::ModbusRequest& command, std::string& error) {
@@ -237,101 +542,662 @@ bool ApplicationCore::sendCommand(const protocol::ModbusRequest& command, std::s
         return false;
     }
 
-    const auto frame = protocolHandler_.createFrame(command, device->session->connectionType());
-    transportManager_.sendToSession(frame, device->session);
+    protocol::ModbusRequest request = command;
+    if (device->session->connectionType() == transport::ConnectionType::Tcp) {
+        request.transactionId = device->session->nextTransactionId();
+    }
+
+    auto frame = device->session->acquireFrame();
+    if (!protocolHandler_.encodeFrame(request, device->session->connectionType(), *frame, error)) {
+        return false;
+    }
+    transportManager_.sendToSession(std::move(frame), device->session);
     return true;
 }
 
-bool ApplicationCore::sendReadAndWait(const protocol::ModbusRequest& command, json::object& result, std::string& error, std::uint32_t timeoutMs) {
-    const auto token = nextReadToken_.fetch_add(1);
+void ApplicationCore::submit(const protocol::ModbusRequest& command, std::uint32_t timeoutMs, ReadCallback onRead,
+                             WriteCallback onWrite, CancelToken cancelToken) {
+    auto device = deviceManager_.firstConnected();
+    if (!device || !device->session) {
+        if (onRead) {
+            onRead(ReadOutcome{false, "No active device session", {}});
+        } else {
+            onWrite(WriteOutcome{false, "No active device session"});
+        }
+        return;
+    }
+    const auto& session = device->session;
+
+    PendingTransaction txn;
+    txn.sessionId = session->id();
+    txn.request = command;
+    txn.deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    txn.cancelToken = cancelToken;
+    txn.onRead = std::move(onRead);
+    txn.onWrite = std::move(onWrite);
+
+    Deferred deferred;
     {
-        std::lock_guard<std::mutex> lock(pendingReadsMutex_);
-        pendingReads_.push_back(PendingReadContext{token, command.slaveId, command.startAddress, command.count});
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (txn.onRead && attachToPendingLocked(txn.sessionId, command, txn.deadline, cancelToken, txn.onRead)) {
+            armReaperLocked();
+            return;
+        }
+
+        trackDeadlineLocked(txn.deadline);
+        txn.token = nextToken_.fetch_add(1);
+        const auto waiting = waiting_.find(txn.sessionId);
+        const auto inFlight = inFlightBySession_.find(txn.sessionId);
+        const bool slotFree = waiting == waiting_.end() &&
+                              (inFlight == inFlightBySession_.end() || inFlight->second < windowFor(*session));
+        if (slotFree) {
+            launchLocked(std::move(txn), session, deferred);
+        } else {
+            // Behind everything already queued, so requests of one session keep their submission order.
+            waiting_[txn.sessionId].emplace_back(std::move(txn), session);
+        }
+        armReaperLocked();
+    }
+    runDeferred(deferred);
+}
+
+void ApplicationCore::launchLocked(PendingTransaction txn, const transport::SessionPtr& session, Deferred& deferred) {
+    const bool tcp = session->connectionType() == transport::ConnectionType::Tcp;
+    if (tcp) {
+        txn.request.transactionId = session->nextTransactionId();
+    }
+
+    auto frame = session->acquireFrame();
+    std::string error;
+    if (!protocolHandler_.encodeFrame(txn.request, session->connectionType(), *frame, error)) {
+        finishLocked(txn, ReadOutcome{false, std::move(error), {}}, deferred);
+        return;
     }
 
-    if (!sendCommand(command, error)) {
-        std::lock_guard<std::mutex> lock(pendingReadsMutex_);
-        const auto it = std::find_if(pendingReads_.begin(), pendingReads_.end(),
-                                     [&](const PendingReadContext& ctx) { return ctx.token == token; });
-        if (it != pendingReads_.end()) {
-            pendingReads_.erase(it);
+    auto& inFlight = inFlightBySession_[txn.sessionId];
+    txn.solo = inFlight == 0;
+    ++inFlight;
+    txn.sentAt = Clock::now();
+    if (isWriteFunction(txn.request.function)) {
+        blockJoinsLocked(txn.sessionId, txn.request.slaveId, txn.request.startAddress, txn.request.values.size());
+    }
+
+    if (tcp) {
+        const auto key = pendingKey(txn.sessionId, txn.request.transactionId);
+        pendingByTransaction_[key] = std::move(txn);
+    } else {
+        pendingRtu_.push_back(std::move(txn));
+    }
+    deferred.frames.emplace_back(std::move(frame), session);
+}
+
+void ApplicationCore::finishLocked(PendingTransaction& txn, ReadOutcome outcome, Deferred& deferred) {
+    untrackDeadlineLocked(txn.deadline);
+    if (protocol::isReadFunction(txn.request.function)) {
+        completeFollowersLocked(txn.token, txn.sessionId, outcome, deferred);
+    }
+    if (txn.onRead) {
+        deferred.callbacks.emplace_back(txn.sessionId,
+            [onRead = std::move(txn.onRead), outcome = std::move(outcome)]() mutable { onRead(std::move(outcome)); });
+    } else if (txn.onWrite) {
+        deferred.callbacks.emplace_back(txn.sessionId, [onWrite = std::move(txn.onWrite), outcome = WriteOutcome{outcome.ok, outcome.error, outcome.exceptionCode}]() mutable {
+            onWrite(std::move(outcome));
+        });
+    }
+}
+
+void ApplicationCore::pumpLocked(std::uint64_t sessionId, Deferred& deferred) {
+    const auto it = waiting_.find(sessionId);
+    if (it == waiting_.end()) {
+        return;
+    }
+
+    auto& queue = it->second;
+    while (!queue.empty()) {
+        const auto inFlight = inFlightBySession_.find(sessionId);
+        if (inFlight != inFlightBySession_.end() && inFlight->second >= windowFor(*queue.front().second)) {
+            break;
         }
+        auto [txn, session] = std::move(queue.front());
+        queue.pop_front();
+        launchLocked(std::move(txn), session, deferred);
+    }
+    if (queue.empty()) {
+        waiting_.erase(it);
+    }
+}
+
+template <typename T>
+T ApplicationCore::waitFor(std::future<T>& future, std::uint32_t timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs) + kReaperSlack;
+    while (future.wait_until(deadline) != std::future_status::ready) {
+        // Every request behind this future is past its deadline by now, yet the reaper has not run:
+        // its timer shares the workers with blocked callers. Expire them from here instead.
+        Deferred deferred;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            reapExpiredLocked(Clock::now(), deferred);
+            armReaperLocked();
+        }
+        runDeferred(deferred);
+        deadline = Clock::now() + kReaperSlack;
+    }
+    return future.get();
+}
+
+std::uint64_t ApplicationCore::pendingKey(std::uint64_t sessionId, std::uint16_t transactionId) noexcept {
+    return (sessionId << 16) | transactionId;
+}
+
+bool ApplicationCore::matchesReply(const protocol::ModbusRequest& request, const protocol::ModbusResponse& response,
+                                   protocol::FunctionCode function) noexcept {
+    if (response.slaveId != request.slaveId || function != request.function) {
         return false;
     }
+    if (response.isException) {
+        return true;
+    }
+    switch (function) {
+        case protocol::FunctionCode::ReadHoldingRegisters:
+        case protocol::FunctionCode::ReadInputRegisters:
+            return response.values.size() == request.count;
+        case protocol::FunctionCode::WriteSingleRegister:
+            return !request.values.empty() && response.address == request.startAddress && response.quantity == request.values[0];
+        case protocol::FunctionCode::WriteMultipleRegisters:
+            return response.address == request.startAddress && response.quantity == request.values.size();
+    }
+    return false;
+}
 
-    std::unique_lock<std::mutex> lock(pendingReadsMutex_);
-    const auto ready = pendingReadsCv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
-        return completedReads_.find(token) != completedReads_.end();
-    });
+std::size_t ApplicationCore::windowFor(const transport::Session& session) const noexcept {
+    return session.connectionType() == transport::ConnectionType::Tcp ? maxInFlight_.load() : 1;
+}
 
-    if (!ready) {
-        const auto pendingIt = std::find_if(pendingReads_.begin(), pendingReads_.end(),
-                                            [&](const PendingReadContext& ctx) { return ctx.token == token; });
-        if (pendingIt != pendingReads_.end()) {
-            pendingReads_.erase(pendingIt);
+bool ApplicationCore::attachToPendingLocked(std::uint64_t sessionId, const protocol::ModbusRequest& command,
+                                            Clock::time_point deadline, CancelToken cancelToken, ReadCallback& onRead) {
+    if (command.count == 0) {
+        return false;
+    }
+
+    // A queued write to the range must be observed, so the read has to queue up behind it.
+    const auto waiting = waiting_.find(sessionId);
+    if (waiting != waiting_.end()) {
+        for (const auto& [queued, _] : waiting->second) {
+            if (isWriteFunction(queued.request.function) && overlaps(queued.request, command.slaveId, command.startAddress, command.count)) {
+                return false;
+            }
         }
+    }
+
+    auto covers = [&](const PendingTransaction& txn) {
+        const auto& request = txn.request;
+        return txn.joinable && txn.sessionId == sessionId && request.slaveId == command.slaveId &&
+               request.function == command.function && request.startAddress <= command.startAddress &&
+               static_cast<std::uint32_t>(command.startAddress) + command.count <=
+                   static_cast<std::uint32_t>(request.startAddress) + request.count;
+    };
 
-        completedReads_.erase(token);
-        error = "Timeout waiting for Modbus read response";
+    const PendingTransaction* leader = nullptr;
+    for (const auto& txn : pendingRtu_) {
+        if (covers(txn)) {
+            leader = &txn;
+            break;
+        }
+    }
+    if (!leader) {
+        for (const auto& [_, txn] : pendingByTransaction_) {
+            if (covers(txn)) {
+                leader = &txn;
+                break;
+            }
+        }
+    }
+    if (!leader) {
         return false;
     }
 
-    result = completedReads_[token];
-    completedReads_.erase(token);
+    const auto followerDeadline = std::min(deadline, leader->deadline);
+    followers_[nextToken_.fetch_add(1)] = FollowerRead{leader->token, sessionId, command.startAddress, command.count,
+                                                       followerDeadline, cancelToken, std::move(onRead)};
+    trackDeadlineLocked(followerDeadline);
+    readsDeduplicated_.fetch_add(1, std::memory_order_relaxed);
     return true;
 }
 
-void ApplicationCore::onTransportFrame(const std::vector<std::uint8_t>& frame, const transport::SessionPtr& session) {
-    if (!session) {
+void ApplicationCore::completeFollowersLocked(std::uint64_t leaderToken, std::uint64_t sessionId, const ReadOutcome& outcome,
+                                              Deferred& deferred) {
+    for (auto it = followers_.begin(); it != followers_.end();) {
+        if (it->second.leaderToken != leaderToken) {
+            ++it;
+            continue;
+        }
+
+        ReadOutcome slice;
+        if (!outcome.ok) {
+            slice.error = outcome.error;
+            slice.exceptionCode = outcome.exceptionCode;
+        } else {
+            protocol::ModbusRequest part;
+            part.startAddress = it->second.address;
+            part.count = it->second.count;
+            slice.ok = ReadPlanner::extract(outcome.result, part, slice.result);
+            if (!slice.ok) {
+                slice.error = "Short Modbus read response";
+            }
+        }
+        deferred.callbacks.emplace_back(sessionId,
+            [onRead = std::move(it->second.onRead), slice = std::move(slice)]() mutable { onRead(std::move(slice)); });
+        untrackDeadlineLocked(it->second.deadline);
+        it = followers_.erase(it);
+    }
+}
+
+void ApplicationCore::blockJoinsLocked(std::uint64_t sessionId, std::uint8_t slaveId, std::uint16_t address, std::size_t count) {
+    auto block = [&](PendingTransaction& txn) {
+        if (txn.sessionId == sessionId && txn.request.function == protocol::FunctionCode::ReadHoldingRegisters &&
+            overlaps(txn.request, slaveId, address, count)) {
+            txn.joinable = false;
+        }
+    };
+    for (auto& txn : pendingRtu_) {
+        block(txn);
+    }
+    for (auto& [_, txn] : pendingByTransaction_) {
+        block(txn);
+    }
+}
+
+void ApplicationCore::reap(std::uint64_t generation) {
+    Deferred deferred;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (generation != reaperGeneration_) {
+            return;
+        }
+        reaperTimer_ = 0;
+        reaperArmedFor_.reset();
+        reapExpiredLocked(Clock::now(), deferred);
+        armReaperLocked();
+    }
+    runDeferred(deferred);
+}
+
+void ApplicationCore::reapExpiredLocked(Clock::time_point now, Deferred& deferred) {
+    if (deadlines_.empty() || *deadlines_.begin() > now) {
         return;
     }
 
-    static std::atomic<std::int64_t> requestId{0};
-    const auto id = requestId.fetch_add(1);
-    const auto responses = protocolHandler_.processIncomingBuffer(frame, session->connectionType(), id);
-    for (const auto& response : responses) {
-        if (response.is_object()) {
-            const auto& obj = response.as_object();
-            if (obj.contains("result") && obj.at("result").is_object()) {
-                handleReadResponse(obj);
+    auto timeout = [](const PendingTransaction& txn) {
+        return ReadOutcome{false, isWriteFunction(txn.request.function) ? "Timeout waiting for Modbus write response"
+                                                                        : "Timeout waiting for Modbus read response", {}};
+    };
+
+    for (auto it = followers_.begin(); it != followers_.end();) {
+        if (it->second.deadline <= now) {
+            deferred.callbacks.emplace_back(it->second.sessionId, [onRead = std::move(it->second.onRead)]() {
+                onRead(ReadOutcome{false, "Timeout waiting for Modbus read response", {}});
+            });
+            ++recovery_.timeouts;
+            untrackDeadlineLocked(it->second.deadline);
+            it = followers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::vector<std::uint64_t> released;
+    for (auto it = pendingRtu_.begin(); it != pendingRtu_.end();) {
+        if (it->deadline <= now) {
+            ++recovery_.timeouts;
+            retireLocked(*it, true, timeout(*it), now, deferred, released);
+            it = pendingRtu_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = pendingByTransaction_.begin(); it != pendingByTransaction_.end();) {
+        if (it->second.deadline <= now) {
+            ++recovery_.timeouts;
+            retireLocked(it->second, false, timeout(it->second), now, deferred, released);
+            it = pendingByTransaction_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = waiting_.begin(); it != waiting_.end();) {
+        auto& queue = it->second;
+        for (auto entry = queue.begin(); entry != queue.end();) {
+            if (entry->first.deadline <= now) {
+                ++recovery_.timeouts;
+                finishLocked(entry->first, ReadOutcome{false, "Timeout waiting for a free in-flight slot", {}}, deferred);
+                entry = queue.erase(entry);
+            } else {
+                ++entry;
             }
         }
-        emitJson(response);
+        it = queue.empty() ? waiting_.erase(it) : std::next(it);
+    }
+
+    for (auto it = draining_.begin(); it != draining_.end();) {
+        if (it->until <= now) {
+            ++recovery_.drainExpired;
+            if (it->holdsSlot) {
+                releaseSlotLocked(it->sessionId);
+                released.push_back(it->sessionId);
+            }
+            untrackDeadlineLocked(it->until);
+            it = draining_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto sessionId : released) {
+        pumpLocked(sessionId, deferred);
     }
 }
 
-void ApplicationCore::handleReadResponse(const json::object& responseObject) {
-    const auto& result = responseObject.at("result").as_object();
-    if (!result.contains("function") || !result.at("function").is_string()) {
+void ApplicationCore::retireLocked(PendingTransaction& txn, bool positional, ReadOutcome outcome, Clock::time_point now,
+                                   Deferred& deferred, std::vector<std::uint64_t>& released) {
+    const bool drain = drainWindow_.count() > 0;
+    if (drain) {
+        draining_.push_back(DrainEntry{txn.sessionId, txn.request, now + drainWindow_, positional});
+        trackDeadlineLocked(draining_.back().until);
+    }
+    if (!drain || !positional) {
+        releaseSlotLocked(txn.sessionId);
+        released.push_back(txn.sessionId);
+    }
+    finishLocked(txn, std::move(outcome), deferred);
+}
+
+std::size_t ApplicationCore::cancel(CancelToken token) {
+    if (token == 0) {
+        return 0;
+    }
+
+    const ReadOutcome cancelled{false, "Request cancelled", {}};
+    std::size_t count = 0;
+    Deferred deferred;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        const auto now = Clock::now();
+
+        for (auto it = followers_.begin(); it != followers_.end();) {
+            if (it->second.cancelToken == token) {
+                deferred.callbacks.emplace_back(it->second.sessionId,
+                                                [onRead = std::move(it->second.onRead), cancelled]() { onRead(cancelled); });
+                ++count;
+                untrackDeadlineLocked(it->second.deadline);
+                it = followers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (auto it = waiting_.begin(); it != waiting_.end();) {
+            auto& queue = it->second;
+            for (auto entry = queue.begin(); entry != queue.end();) {
+                if (entry->first.cancelToken == token) {
+                    finishLocked(entry->first, cancelled, deferred);
+                    ++count;
+                    entry = queue.erase(entry);
+                } else {
+                    ++entry;
+                }
+            }
+            it = queue.empty() ? waiting_.erase(it) : std::next(it);
+        }
+
+        // A read other callers joined keeps going for them; only its own caller is told it was cancelled.
+        auto detach = [&](PendingTransaction& txn) {
+            const bool joined = std::any_of(followers_.begin(), followers_.end(),
+                                            [&](const auto& follower) { return follower.second.leaderToken == txn.token; });
+            if (!joined) {
+                return false;
+            }
+            if (txn.onRead) {
+                deferred.callbacks.emplace_back(txn.sessionId, [onRead = std::move(txn.onRead), cancelled]() { onRead(cancelled); });
+                txn.onRead = nullptr;
+            }
+            txn.cancelToken = 0;
+            ++count;
+            return true;
+        };
+
+        std::vector<std::uint64_t> released;
+        for (auto it = pendingRtu_.begin(); it != pendingRtu_.end();) {
+            if (it->cancelToken == token && !detach(*it)) {
+                retireLocked(*it, true, cancelled, now, deferred, released);
+                ++count;
+                it = pendingRtu_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = pendingByTransaction_.begin(); it != pendingByTransaction_.end();) {
+            if (it->second.cancelToken == token && !detach(it->second)) {
+                retireLocked(it->second, false, cancelled, now, deferred, released);
+                ++count;
+                it = pendingByTransaction_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (const auto sessionId : released) {
+            pumpLocked(sessionId, deferred);
+        }
+
+        recovery_.cancelled += count;
+        armReaperLocked();
+    }
+    runDeferred(deferred);
+    return count;
+}
+
+void ApplicationCore::setDrainWindow(std::chrono::milliseconds window) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    drainWindow_ = std::max(window, std::chrono::milliseconds::zero());
+}
+
+std::chrono::milliseconds ApplicationCore::drainWindow() const {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    return drainWindow_;
+}
+
+RecoveryStats ApplicationCore::recoveryStats() const {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    return recovery_;
+}
+
+void ApplicationCore::armReaperLocked() {
+    std::optional<Clock::time_point> earliest;
+    if (!deadlines_.empty()) {
+        earliest = *deadlines_.begin();
+    }
+
+    if (reaperTimer_ != 0 && earliest && reaperArmedFor_ && *reaperArmedFor_ <= *earliest) {
+        return;
+    }
+    if (reaperTimer_ != 0) {
+        taskScheduler_.cancel(reaperTimer_);
+        reaperTimer_ = 0;
+    }
+    reaperArmedFor_.reset();
+    ++reaperGeneration_;
+    if (!earliest) {
+        return;
+    }
+
+    const auto delay = std::chrono::ceil<std::chrono::milliseconds>(std::max(*earliest - Clock::now(), Clock::duration::zero()));
+    const auto generation = reaperGeneration_;
+    reaperTimer_ = taskScheduler_.postDelayed(delay, [this, generation]() { reap(generation); });
+    reaperArmedFor_ = earliest;
+}
+
+void ApplicationCore::trackDeadlineLocked(Clock::time_point deadline) {
+    deadlines_.insert(deadline);
+}
+
+void ApplicationCore::untrackDeadlineLocked(Clock::time_point deadline) {
+    const auto it = deadlines_.find(deadline);
+    if (it != deadlines_.end()) {
+        deadlines_.erase(it);
+    }
+}
+
+void ApplicationCore::releaseSlotLocked(std::uint64_t sessionId) {
+    auto it = inFlightBySession_.find(sessionId);
+    if (it == inFlightBySession_.end()) {
+        return;
+    }
+    if (it->second > 0) {
+        --it->second;
+    }
+    if (it->second == 0) {
+        inFlightBySession_.erase(it);
+    }
+}
+
+void ApplicationCore::runDeferred(Deferred& deferred) {
+    for (auto& [frame, session] : deferred.frames) {
+        transportManager_.sendToSession(std::move(frame), session);
+    }
+    // One task per run of callbacks for the same session keeps the strand traffic down.
+    for (auto first = deferred.callbacks.begin(); first != deferred.callbacks.end();) {
+        const auto sessionId = first->first;
+        auto batch = std::make_shared<std::vector<std::function<void()>>>();
+        for (; first != deferred.callbacks.end() && first->first == sessionId; ++first) {
+            batch->push_back(std::move(first->second));
+        }
+        TaskScheduler::Task task = [batch]() {
+            for (auto& callback : *batch) {
+                callback();
+            }
+        };
+        // A stopped scheduler runs nothing, yet every callback must run exactly once.
+        if (!taskScheduler_.post(sessionId, task)) {
+            task();
+        }
+    }
+}
+
+void ApplicationCore::absorb(const ReadResult& update) {
+    registerCache_.store(update.slaveId, update.function, update.address, update.values.data(), update.values.size());
+    if (subscriptionEngine_.active()) {
+        subscriptionEngine_.ingest(update);
+    }
+}
+
+void ApplicationCore::onTransportFrame(transport::ByteSpan frame, const transport::SessionPtr& session) {
+    if (!session) {
         return;
     }
 
-    const std::string function = std::string(result.at("function").as_string().c_str());
-    if (!isReadFunctionString(function)) {
+    auto* decoder = dynamic_cast<protocol::StreamDecoder*>(session->context());
+    if (!decoder) {
         return;
     }
 
-    PendingReadContext pending;
+    // Only matching stays on the io thread. Cache updates, subscriptions, completion callbacks and JSON
+    // building go to the session's strand, so they keep arrival order without stalling the reader.
+    protocolHandler_.processIncomingBuffer(*decoder, frame, [this, &session](const protocol::ModbusResponse& response) {
+        handleResponse(response, session);
+        if (jsonResponseCallback_) {
+            taskScheduler_.post(session->id(), [this, response]() {
+                static std::atomic<std::int64_t> requestId{0};
+                emitJson(protocolHandler_.responseToJson(response, requestId.fetch_add(1)));
+            });
+        }
+    });
+}
+
+void ApplicationCore::handleResponse(const protocol::ModbusResponse& response, const transport::SessionPtr& session) {
+    // An exception reply carries the request's function code with the high bit set.
+    const auto function = static_cast<protocol::FunctionCode>(static_cast<std::uint8_t>(response.function) & 0x7F);
+    const bool tcp = session->connectionType() == transport::ConnectionType::Tcp;
+
+    Deferred deferred;
     {
-        std::lock_guard<std::mutex> lock(pendingReadsMutex_);
-        if (pendingReads_.empty()) {
-            return;
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        PendingTransaction txn;
+        bool matched = false;
+        if (tcp) {
+            const auto it = pendingByTransaction_.find(pendingKey(session->id(), response.transactionId));
+            if (it != pendingByTransaction_.end() && matchesReply(it->second.request, response, function)) {
+                txn = std::move(it->second);
+                pendingByTransaction_.erase(it);
+                matched = true;
+            }
+        } else {
+            const auto it = std::find_if(pendingRtu_.begin(), pendingRtu_.end(),
+                                         [&](const PendingTransaction& pending) { return pending.sessionId == session->id(); });
+            if (it != pendingRtu_.end() && matchesReply(it->request, response, function)) {
+                txn = std::move(*it);
+                pendingRtu_.erase(it);
+                matched = true;
+            }
         }
-        pending = pendingReads_.front();
-        pendingReads_.pop_front();
 
-        json::object enriched;
-        enriched["ok"] = true;
-        enriched["slave_id"] = pending.slaveId;
-        enriched["address"] = pending.address;
-        enriched["count"] = pending.count;
-        enriched["function"] = function;
-        enriched["values"] = result.contains("values") ? result.at("values") : json::array{};
+        if (matched) {
+            completeLocked(txn, response, deferred);
+        } else {
+            discardLateLocked(session->id(), response, function, tcp, deferred);
+        }
+    }
+    runDeferred(deferred);
+}
+
+void ApplicationCore::completeLocked(PendingTransaction& txn, const protocol::ModbusResponse& response, Deferred& deferred) {
+    releaseSlotLocked(txn.sessionId);
 
-        completedReads_[pending.token] = std::move(enriched);
+    const auto& request = txn.request;
+    ReadOutcome outcome;
+    outcome.ok = !response.isException;
+    if (response.isException) {
+        outcome.exceptionCode = response.exceptionCode;
+        outcome.error = "Modbus exception " + std::to_string(response.exceptionCode) + " (" +
+                        protocol::ProtocolHandler::exceptionToString(response.exceptionCode) + ")";
+    } else if (protocol::isReadFunction(request.function)) {
+        if (txn.solo) {
+            readPlanner_.recordRoundTrip(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - txn.sentAt), request.count);
+        }
+        outcome.result = ReadResult{request.slaveId, response.function, request.startAddress, request.count, response.values};
+        // Queued ahead of the caller's callback on the same strand, so the caller reads its own result back.
+        deferred.callbacks.emplace_back(txn.sessionId, [this, update = outcome.result]() { absorb(update); });
+    } else {
+        ReadResult update{request.slaveId, protocol::FunctionCode::ReadHoldingRegisters, request.startAddress,
+                          static_cast<std::uint16_t>(request.values.size()), {}};
+        for (const auto value : request.values) {
+            update.values.push_back(value);
+        }
+        deferred.callbacks.emplace_back(txn.sessionId, [this, update = std::move(update)]() { absorb(update); });
     }
+    finishLocked(txn, std::move(outcome), deferred);
+    pumpLocked(txn.sessionId, deferred);
+}
 
-    pendingReadsCv_.notify_all();
+void ApplicationCore::discardLateLocked(std::uint64_t sessionId, const protocol::ModbusResponse& response,
+                                        protocol::FunctionCode function, bool tcp, Deferred& deferred) {
+    const auto it = std::find_if(draining_.begin(), draining_.end(), [&](const DrainEntry& entry) {
+        return entry.sessionId == sessionId && (!tcp || entry.request.transactionId == response.transactionId) &&
+               matchesReply(entry.request, response, function);
+    });
+    if (it == draining_.end()) {
+        ++recovery_.unmatched;
+        return;
+    }
+
+    ++recovery_.lateDrained;
+    const bool holdsSlot = it->holdsSlot;
+    untrackDeadlineLocked(it->until);
+    draining_.erase(it);
+    if (holdsSlot) {
+        releaseSlotLocked(sessionId);
+        pumpLocked(sessionId, deferred);
+    }
 }
 
 void ApplicationCore::emitJson(const json::value& value) const {
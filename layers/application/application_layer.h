@@ -3,27 +3,32 @@
 #include <boost/json.hpp>
 
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "DeviceManager.h"
+#include "PollingEngine.h"
+#include "ReadPlanner.h"
+#include "ReadResult.h"
+#include "RegisterCache.h"
+#include "SubscriptionEngine.h"
+#include "TaskScheduler.h"
+#include "WritePlanner.h"
 #include "layers/protocol/protocol_layer.h"
 #include "layers/transport/transport_layer.h"
 
 namespace application {
 
-class TaskScheduler {
-public:
-    void post(const std::function<void()>& task) const { task(); }
-};
-
 struct TransportConfig {
     transport::ConnectionType type = transport::ConnectionType::Tcp;
     std::string host;
@@ -31,63 +36,237 @@ struct TransportConfig {
     std::string serialPort;
     std::uint32_t baudRate = 9600;
     std::uint8_t stopBits = 1;
+    std::uint32_t connectTimeoutMs = static_cast<std::uint32_t>(transport::kDefaultConnectTimeout.count());
     bool active = false;
 };
 
+// How the request tables recovered from replies that did not arrive in time.
+struct RecoveryStats {
+    std::uint64_t timeouts = 0;
+    std::uint64_t cancelled = 0;
+    std::uint64_t lateDrained = 0;   // late replies recognised and dropped within the drain window
+    std::uint64_t drainExpired = 0;  // drain windows that closed without a reply
+    std::uint64_t unmatched = 0;     // replies that matched neither a pending nor a draining request
+};
+
 class ApplicationCore {
 public:
-    explicit ApplicationCore(transport::TransportManager& transportManager);
+    explicit ApplicationCore(transport::TransportManager& transportManager,
+                             std::size_t workerThreads = TaskScheduler::kDefaultWorkers);
+    ~ApplicationCore();
 
     void setJsonResponseCallback(std::function<void(const boost::json::value&)> cb);
 
-    bool openTcpTransport(const std::string& host, std::uint16_t port, std::string& error);
-    bool openRtuTransport(const std::string& serialPort, std::uint32_t baudRate, std::uint8_t stopBits, std::string& error);
+    bool openTcpTransport(const std::string& host, std::uint16_t port, std::string& error,
+                          std::uint32_t connectTimeoutMs = transport::kDefaultConnectTimeout.count());
+    bool openRtuTransport(const std::string& serialPort, std::uint32_t baudRate, std::uint8_t stopBits, std::string& error,
+                          std::uint32_t connectTimeoutMs = transport::kDefaultConnectTimeout.count());
     bool closeActiveTransport(boost::json::object& closedInfo);
     bool switchTransport(const TransportConfig& target, std::string& error, boost::json::object& closedInfo);
     TransportConfig transportStatus() const;
+    protocol::ReceiveStats receiveStats() const noexcept { return protocolHandler_.receiveStats(); }
+    std::vector<transport::SessionStats> sessionStats() const;
+    // Reads served by attaching to an identical or covering read already on the wire.
+    std::uint64_t readsDeduplicated() const noexcept { return readsDeduplicated_.load(); }
     std::vector<std::string> listSerialPorts() const;
 
+    // Non-blocking API. Each request takes a completion slot and its callback runs exactly once: on the
+    // scheduler strand of its session when the response is matched, the request times out or it is
+    // cancelled, or inline when the request fails or is answered from the cache at once. Callbacks must
+    // not block; hand longer work to scheduler().
+    using ReadCallback = std::function<void(ReadOutcome)>;
+    using WriteCallback = std::function<void(WriteOutcome)>;
+    using GroupCallback = std::function<void(GroupOutcome)>;
+    using EachCallback = std::function<void(std::vector<ReadOutcome>)>;
+    // Tags requests so they can be cancelled together; 0 is never issued and means "not cancellable".
+    using CancelToken = std::uint64_t;
+
+    // With maxAgeMs > 0, registers seen on the wire within that age come from the register cache and
+    // only the stale or missing sub-ranges are fetched; 0 always reads the device.
+    void readAsync(const protocol::ModbusRequest& request, std::uint32_t timeoutMs, ReadCallback onDone,
+                   std::uint32_t maxAgeMs = 0, CancelToken cancelToken = 0);
+    // Completes once the device has echoed the write; the register cache only ever sees confirmed values.
+    void writeAsync(const protocol::ModbusRequest& request, std::uint32_t timeoutMs, WriteCallback onDone,
+                    CancelToken cancelToken = 0);
+    // Coalesces the items through ReadPlanner (unless `coalesce` is false) and completes with one result
+    // per item; the first failed frame fails the group and later responses are dropped.
+    void groupAsync(const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs, bool coalesce,
+                    GroupCallback onDone, CancelToken cancelToken = 0);
+    // Sends the requests as-is (pipelined on TCP) and completes with one outcome per request, in order,
+    // once all of them are done; one failure does not abort the rest.
+    void readEachAsync(const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs, EachCallback onDone);
+
+    CancelToken newCancelToken() noexcept { return nextToken_.fetch_add(1); }
+    // Completes every request tagged with `token` as cancelled and returns how many there were. A read
+    // that other callers have joined stays on the wire for them.
+    std::size_t cancel(CancelToken token);
+
+    // A request that times out or is cancelled on the wire keeps listening this long for its late
+    // reply, which is then dropped instead of being taken for a newer request's. On RTU the bus stays
+    // reserved meanwhile. Zero disables draining.
+    void setDrainWindow(std::chrono::milliseconds window);
+    std::chrono::milliseconds drainWindow() const;
+    RecoveryStats recoveryStats() const;
+
+    // Fire-and-forget: the responses only reach the JSON response callback.
     bool readRegisters(std::uint8_t slaveId, std::uint16_t address, std::uint16_t count, bool input, std::string& error);
-    bool readRegistersDetailed(std::uint8_t slaveId, std::uint16_t address, std::uint16_t count, bool input,
-                              boost::json::object& result, std::string& error, std::uint32_t timeoutMs = 2000);
-    bool writeSingleRegister(std::uint8_t slaveId, std::uint16_t address, std::uint16_t value, std::string& error);
-    bool writeMultipleRegisters(std::uint8_t slaveId, std::uint16_t address, const std::vector<std::uint16_t>& values, std::string& error);
     bool readGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error);
-    bool readGroupDetailed(const std::vector<protocol::ModbusRequest>& requests, boost::json::array& results,
-                          std::string& error, std::uint32_t timeoutMs = 2000);
-    bool writeGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error);
+
+    // Blocking wrappers over the API above. Must not be called from scheduler tasks: the completions
+    // they wait for run on the scheduler.
+    bool readRegistersDetailed(std::uint8_t slaveId, std::uint16_t address, std::uint16_t count, bool input,
+                              ReadResult& result, std::string& error, std::uint32_t timeoutMs = 2000,
+                              std::uint32_t maxAgeMs = 0);
+    bool writeSingleRegister(std::uint8_t slaveId, std::uint16_t address, std::uint16_t value, std::string& error,
+                             std::uint32_t timeoutMs = 2000);
+    bool writeMultipleRegisters(std::uint8_t slaveId, std::uint16_t address, const std::vector<std::uint16_t>& values,
+                                std::string& error, std::uint32_t timeoutMs = 2000);
+    bool readGroupDetailed(const std::vector<protocol::ModbusRequest>& requests, std::vector<ReadResult>& results,
+                          std::string& error, std::uint32_t timeoutMs = 2000, bool coalesce = true);
+    std::vector<ReadOutcome> readEach(const std::vector<protocol::ModbusRequest>& requests, std::uint32_t timeoutMs = 2000);
+    // Merges the items through WritePlanner (unless `coalesce` is false); `framesSent` receives the frame count.
+    bool writeGroup(const std::vector<protocol::ModbusRequest>& requests, std::string& error, bool coalesce = true,
+                    std::size_t* framesSent = nullptr, std::uint32_t timeoutMs = 2000);
+    std::vector<PlannedWrite> planWriteGroup(const std::vector<protocol::ModbusRequest>& requests, bool coalesce = true) const;
+
+    // Maximum number of outstanding requests per Modbus/TCP session (RTU is always 1). Requests beyond
+    // the window wait in a per-session queue.
+    void setMaxInFlight(std::size_t window);
+    std::size_t maxInFlight() const noexcept { return maxInFlight_.load(); }
+
+    void setReadGapLimit(std::uint16_t registers) { readPlanner_.setGapLimit(registers); }
+    ReadPlannerStats readPlannerStats() const { return readPlanner_.stats(); }
 
     DeviceManager& deviceManager() noexcept { return deviceManager_; }
+    TaskScheduler& scheduler() noexcept { return taskScheduler_; }
+    PollingEngine& polling() noexcept { return pollingEngine_; }
+    RegisterCache& registerCache() noexcept { return registerCache_; }
+    // Fed with every block that reaches the register cache: read responses, and write echoes as
+    // holding registers.
+    SubscriptionEngine& subscriptions() noexcept { return subscriptionEngine_; }
+    SchedulerStats schedulerStats() const { return taskScheduler_.stats(); }
+
+    static constexpr std::size_t kMaxInFlightLimit = 32;
+    static constexpr std::chrono::milliseconds kDefaultDrainWindow{250};
 
 private:
-    struct PendingReadContext {
+    using Clock = std::chrono::steady_clock;
+
+    // One request owning a completion slot, from submission until its response or deadline.
+    struct PendingTransaction {
         std::uint64_t token = 0;
-        std::uint8_t slaveId = 0;
+        std::uint64_t sessionId = 0;
+        protocol::ModbusRequest request;  // as sent, transaction ID included
+        Clock::time_point deadline;
+        Clock::time_point sentAt;
+        bool solo = false;      // nothing else was in flight on the session, so the round trip is a clean sample
+        bool joinable = true;   // cleared once a write overlaps the range: later reads must see the write
+        CancelToken cancelToken = 0;
+        ReadCallback onRead;    // empty once the caller cancelled while followers still wait
+        WriteCallback onWrite;
+    };
+
+    // A read that attached to an in-flight read covering its range instead of going to the wire.
+    struct FollowerRead {
+        std::uint64_t leaderToken = 0;
+        std::uint64_t sessionId = 0;
         std::uint16_t address = 0;
         std::uint16_t count = 0;
+        Clock::time_point deadline;
+        CancelToken cancelToken = 0;
+        ReadCallback onRead;
+    };
+
+    // A request that timed out or was cancelled on the wire, kept until its late reply shows up.
+    struct DrainEntry {
+        std::uint64_t sessionId = 0;
+        protocol::ModbusRequest request;
+        Clock::time_point until;
+        bool holdsSlot = false;  // RTU: positional matching needs the bus quiet before the next request
+    };
+
+    // Work collected under the lock. Once it is released the frames are sent, and the callbacks are
+    // posted to the scheduler strand of their session, so they leave the io thread but keep their order.
+    struct Deferred {
+        std::vector<std::pair<transport::FramePtr, transport::SessionPtr>> frames;
+        std::vector<std::pair<std::uint64_t, std::function<void()>>> callbacks;  // (session, callback)
     };
 
     bool sendCommand(const protocol::ModbusRequest& command, std::string& error);
-    bool sendReadAndWait(const protocol::ModbusRequest& command, boost::json::object& result, std::string& error, std::uint32_t timeoutMs);
+    void submit(const protocol::ModbusRequest& command, std::uint32_t timeoutMs, ReadCallback onRead, WriteCallback onWrite,
+                CancelToken cancelToken);
+    void launchLocked(PendingTransaction txn, const transport::SessionPtr& session, Deferred& deferred);
+    void finishLocked(PendingTransaction& txn, ReadOutcome outcome, Deferred& deferred);
+    // Ends an in-flight transaction without its reply; `released` collects sessions whose slot freed up.
+    void retireLocked(PendingTransaction& txn, bool positional, ReadOutcome outcome, Clock::time_point now,
+                      Deferred& deferred, std::vector<std::uint64_t>& released);
+    void completeLocked(PendingTransaction& txn, const protocol::ModbusResponse& response, Deferred& deferred);
+    void discardLateLocked(std::uint64_t sessionId, const protocol::ModbusResponse& response, protocol::FunctionCode function,
+                           bool tcp, Deferred& deferred);
+    void pumpLocked(std::uint64_t sessionId, Deferred& deferred);
+    // Waits for a blocking wrapper; reaps on its own if the reaper timer is starved of workers.
+    template <typename T>
+    T waitFor(std::future<T>& future, std::uint32_t timeoutMs);
+
+    static std::uint64_t pendingKey(std::uint64_t sessionId, std::uint16_t transactionId) noexcept;
+    // Slave, function and expected length (or echoed address and value) of the reply fit the request.
+    static bool matchesReply(const protocol::ModbusRequest& request, const protocol::ModbusResponse& response,
+                             protocol::FunctionCode function) noexcept;
+    std::size_t windowFor(const transport::Session& session) const noexcept;
+    bool attachToPendingLocked(std::uint64_t sessionId, const protocol::ModbusRequest& command, Clock::time_point deadline,
+                               CancelToken cancelToken, ReadCallback& onRead);
+    void completeFollowersLocked(std::uint64_t leaderToken, std::uint64_t sessionId, const ReadOutcome& outcome,
+                                 Deferred& deferred);
+    void blockJoinsLocked(std::uint64_t sessionId, std::uint8_t slaveId, std::uint16_t address, std::size_t count);
+    void reap(std::uint64_t generation);
+    void reapExpiredLocked(Clock::time_point now, Deferred& deferred);
+    void armReaperLocked();
+    // Every request, follower and drain entry adds its deadline here and removes it when it goes.
+    void trackDeadlineLocked(Clock::time_point deadline);
+    void untrackDeadlineLocked(Clock::time_point deadline);
+    void releaseSlotLocked(std::uint64_t sessionId);
+    void runDeferred(Deferred& deferred);
+    // Puts a block confirmed by the device into the register cache and feeds it to the subscriptions.
+    void absorb(const ReadResult& update);
 
-    void onTransportFrame(const std::vector<std::uint8_t>& frame, const transport::SessionPtr& session);
-    void handleReadResponse(const boost::json::object& responseObject);
+    void onTransportFrame(transport::ByteSpan frame, const transport::SessionPtr& session);
+    void handleResponse(const protocol::ModbusResponse& response, const transport::SessionPtr& session);
     void emitJson(const boost::json::value& value) const;
 
     transport::TransportManager& transportManager_;
     protocol::ProtocolHandler protocolHandler_;
     DeviceManager deviceManager_;
-    TaskScheduler taskScheduler_;
+    ReadPlanner readPlanner_;
+    RegisterCache registerCache_;
     std::function<void(const boost::json::value&)> jsonResponseCallback_;
 
     mutable std::mutex transportConfigMutex_;
     TransportConfig transportConfig_;
 
-    std::atomic<std::uint64_t> nextReadToken_{1};
-    std::mutex pendingReadsMutex_;
-    std::condition_variable pendingReadsCv_;
-    std::deque<PendingReadContext> pendingReads_;
-    std::unordered_map<std::uint64_t, boost::json::object> completedReads_;
+    std::atomic<std::uint64_t> nextToken_{1};
+    std::atomic<std::size_t> maxInFlight_{1};
+    mutable std::mutex pendingMutex_;
+    std::deque<PendingTransaction> pendingRtu_;                                   // RTU: positional matching
+    std::unordered_map<std::uint64_t, PendingTransaction> pendingByTransaction_;  // TCP: keyed by session + transaction ID
+    std::unordered_map<std::uint64_t, std::size_t> inFlightBySession_;
+    std::unordered_map<std::uint64_t, std::deque<std::pair<PendingTransaction, transport::SessionPtr>>> waiting_;
+    std::unordered_map<std::uint64_t, FollowerRead> followers_;
+    std::deque<DrainEntry> draining_;
+    std::chrono::milliseconds drainWindow_ = kDefaultDrainWindow;
+    RecoveryStats recovery_;
+    std::atomic<std::uint64_t> readsDeduplicated_{0};
+
+    // Single timer for every deadline above, re-armed only when the earliest one moves forward.
+    std::multiset<Clock::time_point> deadlines_;
+    TaskScheduler::TaskId reaperTimer_ = 0;
+    std::uint64_t reaperGeneration_ = 0;
+    std::optional<Clock::time_point> reaperArmedFor_;
+
+    // Constructed before the engines that keep a reference to it. Its workers touch most of the state
+    // above, so the destructor joins them before any member is destroyed.
+    TaskScheduler taskScheduler_;
+    PollingEngine pollingEngine_;
+    SubscriptionEngine subscriptionEngine_;
 };
 
 } // namespace application
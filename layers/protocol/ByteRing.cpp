@@ -0,0 +1,95 @@
+#include "ByteRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace protocol {
+
+namespace {
+
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+ByteRing::ByteRing(std::size_t capacity, OverflowPolicy policy)
+    : policy_(policy) {
+    const auto rounded = roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1));
+    storage_ = std::make_unique<std::uint8_t[]>(rounded);
+    mask_ = rounded - 1;
+}
+
+std::size_t ByteRing::write(const std::uint8_t* data, std::size_t count) noexcept {
+    const auto cap = capacity();
+    const auto free = cap - size_;
+    if (count > free) {
+        switch (policy_) {
+            case OverflowPolicy::DropOldest: {
+                if (count >= cap) {
+                    overflowBytes_ += size_ + (count - cap);
+                    data += count - cap;
+                    count = cap;
+                    clear();
+                } else {
+                    const auto drop = count - free;
+                    overflowBytes_ += drop;
+                    consume(drop);
+                }
+                break;
+            }
+            case OverflowPolicy::Reset:
+                overflowBytes_ += size_;
+                clear();
+                if (count > cap) {
+                    overflowBytes_ += count - cap;
+                    data += count - cap;
+                    count = cap;
+                }
+                break;
+            case OverflowPolicy::Reject:
+                overflowBytes_ += count - free;
+                count = free;
+                break;
+        }
+    }
+
+    const auto tail = (head_ + size_) & mask_;
+    const auto first = std::min(count, cap - tail);
+    std::memcpy(storage_.get() + tail, data, first);
+    std::memcpy(storage_.get(), data + first, count - first);
+    size_ += count;
+    return count;
+}
+
+void ByteRing::consume(std::size_t count) noexcept {
+    count = std::min(count, size_);
+    head_ = (head_ + count) & mask_;
+    size_ -= count;
+    if (size_ == 0) {
+        head_ = 0;
+    }
+}
+
+void ByteRing::clear() noexcept {
+    head_ = 0;
+    size_ = 0;
+}
+
+const std::uint8_t* ByteRing::view(std::size_t offset, std::size_t count, std::uint8_t* scratch) const noexcept {
+    const auto start = (head_ + offset) & mask_;
+    if (start + count <= capacity()) {
+        return storage_.get() + start;
+    }
+
+    const auto first = capacity() - start;
+    std::memcpy(scratch, storage_.get() + start, first);
+    std::memcpy(scratch + first, storage_.get(), count - first);
+    return scratch;
+}
+
+} // namespace protocol
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace protocol {
+
+// What ByteRing::write does when incoming bytes do not fit.
+enum class OverflowPolicy {
+    DropOldest, // discard the oldest buffered bytes; the parser resynchronises on the remainder
+    Reset,      // discard everything buffered, then store the incoming bytes
+    Reject      // keep buffered bytes, drop the incoming bytes that do not fit
+};
+
+// Fixed-capacity byte FIFO used to reassemble frames that span several reads.
+// Capacity is rounded up to a power of two; write() never allocates and consume() is O(1).
+class ByteRing {
+public:
+    explicit ByteRing(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::DropOldest);
+
+    std::size_t size() const noexcept { return size_; }
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::uint64_t overflowBytes() const noexcept { return overflowBytes_; }
+
+    std::uint8_t operator[](std::size_t index) const noexcept { return storage_[(head_ + index) & mask_]; }
+
+    // Returns the number of bytes from data that were stored.
+    std::size_t write(const std::uint8_t* data, std::size_t count) noexcept;
+    void consume(std::size_t count) noexcept;
+    void clear() noexcept;
+
+    // Pointer to count bytes starting at offset if they are contiguous in storage, otherwise
+    // the bytes are copied into scratch and scratch is returned.
+    const std::uint8_t* view(std::size_t offset, std::size_t count, std::uint8_t* scratch) const noexcept;
+
+private:
+    std::unique_ptr<std::uint8_t[]> storage_;
+    std::size_t mask_ = 0;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    OverflowPolicy policy_;
+    std::uint64_t overflowBytes_ = 0;
+};
+
+} // namespace protocol
@@ -1,8 +1,11 @@
 #include "protocol_layer.h"
 
+#include <array>
 #include <cstddef>
 #include <stdexcept>
 
+#include "crc.hpp"
+
 namespace protocol {
 
 bool ProtocolHandler::jsonToRequest(const json::value& payload, ModbusRequest& out, std::string& error) const {
@@ -89,6 +92,7 @@ json::value ProtocolHandler::responseToJson(const ModbusResponse& response, std:
     json::object result;
     result["slave_id"] = response.slaveId;
     result["function"] = functionToString(response.function);
+    result["transaction_id"] = response.transactionId;
     json::array values;
     for (const auto value : response.values) {
         values.push_back(value);
@@ -98,67 +102,137 @@ json::value ProtocolHandler::responseToJson(const ModbusResponse& response, std:
     return root;
 }
 
-std::vector<std::uint8_t> ProtocolHandler::createFrame(
-    const ModbusRequest& request,
-    transport::ConnectionType connectionType) const {
-    auto pdu = createPdu(request);
+bool ProtocolHandler::encodeFrame(const ModbusRequest& request, transport::ConnectionType connectionType,
+                                  transport::FrameBuffer& out, std::string& error) const {
+    if (request.function == FunctionCode::WriteMultipleRegisters &&
+        (request.values.empty() || request.values.size() > kMaxWriteRegisters)) {
+        error = "write_multiple needs 1.." + std::to_string(kMaxWriteRegisters) + " values";
+        return false;
+    }
 
+    auto* frame = out.data();
     if (connectionType == transport::ConnectionType::Rtu) {
-        auto frame = pdu;
-        const auto crc = crc16(frame);
-        frame.push_back(static_cast<std::uint8_t>(crc & 0xFF));
-        frame.push_back(static_cast<std::uint8_t>((crc >> 8) & 0xFF));
-        return frame;
+        const auto size = encodePdu(request, frame);
+        const auto crc = MB::CRC::calculateCRC(frame, size);
+        frame[size] = static_cast<std::uint8_t>(crc & 0xFF);
+        frame[size + 1] = static_cast<std::uint8_t>((crc >> 8) & 0xFF);
+        out.resize(size + 2);
+        return true;
     }
 
-    std::vector<std::uint8_t> frame;
-    frame.reserve(6 + pdu.size());
-    frame.push_back(0x00);
-    frame.push_back(0x01);
-    frame.push_back(0x00);
-    frame.push_back(0x00);
-    const auto length = static_cast<std::uint16_t>(pdu.size());
-    frame.push_back(static_cast<std::uint8_t>((length >> 8) & 0xFF));
-    frame.push_back(static_cast<std::uint8_t>(length & 0xFF));
-    frame.insert(frame.end(), pdu.begin(), pdu.end());
-    return frame;
+    const auto length = static_cast<std::uint16_t>(pduSize(request));
+    frame[0] = static_cast<std::uint8_t>((request.transactionId >> 8) & 0xFF);
+    frame[1] = static_cast<std::uint8_t>(request.transactionId & 0xFF);
+    frame[2] = 0x00;
+    frame[3] = 0x00;
+    frame[4] = static_cast<std::uint8_t>((length >> 8) & 0xFF);
+    frame[5] = static_cast<std::uint8_t>(length & 0xFF);
+    out.resize(6 + encodePdu(request, frame + 6));
+    return true;
 }
 
-std::vector<json::value> ProtocolHandler::processIncomingBuffer(
-    const std::vector<std::uint8_t>& chunk,
-    transport::ConnectionType connectionType,
-    std::int64_t requestId) {
-    std::vector<json::value> result;
-    auto& buffer = connectionType == transport::ConnectionType::Tcp ? tcpBuffer_ : rtuBuffer_;
-    buffer.insert(buffer.end(), chunk.begin(), chunk.end());
-
-    if (connectionType == transport::ConnectionType::Tcp) {
-        while (buffer.size() >= 6) {
-            const auto len = static_cast<std::size_t>((buffer[4] << 8) | buffer[5]);
-            if (buffer.size() < 6 + len) {
-                break;
-            }
-            std::vector<std::uint8_t> pdu(buffer.begin() + 6, buffer.begin() + 6 + len);
-            buffer.erase(buffer.begin(), buffer.begin() + 6 + len);
-            result.push_back(responseToJson(parsePdu(pdu), requestId));
+namespace {
+
+// Decoder input backed by one contiguous chunk (the session's receive buffer).
+struct LinearSource {
+    const std::uint8_t* data;
+    std::size_t size;
+
+    std::uint8_t at(std::size_t index) const noexcept { return data[index]; }
+    const std::uint8_t* frame(std::size_t offset, std::size_t, std::uint8_t*) const noexcept { return data + offset; }
+};
+
+// Decoder input backed by the reassembly ring; frames that wrap are copied to a stack scratch buffer.
+struct RingSource {
+    const ByteRing& ring;
+    std::size_t size;
+
+    std::uint8_t at(std::size_t index) const noexcept { return ring[index]; }
+    const std::uint8_t* frame(std::size_t offset, std::size_t count, std::uint8_t* scratch) const noexcept {
+        return ring.view(offset, count, scratch);
+    }
+};
+
+constexpr std::size_t kMaxMbapLength = 254; // unit id + 253-byte PDU
+
+} // namespace
+
+StreamDecoder::StreamDecoder(transport::ConnectionType connectionType)
+    : connectionType_(connectionType) {}
+
+std::unique_ptr<StreamDecoder> ProtocolHandler::createDecoder(transport::ConnectionType connectionType) {
+    // The decoder and its ring are allocated here, once per session; tests/ReceivePathTest checks that
+    // decoding itself never allocates.
+    decodersCreated_.fetch_add(1, std::memory_order_relaxed);
+    return std::make_unique<StreamDecoder>(connectionType);
+}
+
+void ProtocolHandler::processIncomingBuffer(StreamDecoder& decoder, transport::ByteSpan chunk,
+                                            const ResponseHandler& onResponse) {
+    const bool tcp = decoder.connectionType() == transport::ConnectionType::Tcp;
+    auto& ring = decoder.ring_;
+    bytesReceived_.fetch_add(chunk.size, std::memory_order_relaxed);
+
+    if (ring.empty()) {
+        // Fast path: decode in place from the session's receive buffer and keep only a partial tail.
+        const LinearSource source{chunk.data, chunk.size};
+        const auto consumed = tcp ? decodeTcp(source, onResponse) : decodeRtu(source, onResponse);
+        storeTail(ring, chunk.data + consumed, chunk.size - consumed);
+        return;
+    }
+
+    storeTail(ring, chunk.data, chunk.size);
+    const RingSource source{ring, ring.size()};
+    ring.consume(tcp ? decodeTcp(source, onResponse) : decodeRtu(source, onResponse));
+}
+
+ReceiveStats ProtocolHandler::receiveStats() const noexcept {
+    ReceiveStats stats;
+    stats.framesDecoded = framesDecoded_.load(std::memory_order_relaxed);
+    stats.bytesReceived = bytesReceived_.load(std::memory_order_relaxed);
+    stats.overflowBytes = overflowBytes_.load(std::memory_order_relaxed);
+    stats.decodersCreated = decodersCreated_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+template <typename Source>
+std::size_t ProtocolHandler::decodeTcp(const Source& source, const ResponseHandler& onResponse) {
+    std::array<std::uint8_t, transport::kMaxFrameSize> scratch;
+    std::size_t offset = 0;
+    while (source.size >= offset + 6) {
+        const auto protocolId = static_cast<std::uint16_t>((source.at(offset + 2) << 8) | source.at(offset + 3));
+        const auto len = static_cast<std::size_t>((source.at(offset + 4) << 8) | source.at(offset + 5));
+        if (protocolId != 0 || len < 2 || len > kMaxMbapLength) {
+            ++offset; // not an MBAP header: resynchronise
+            continue;
         }
-        return result;
+        if (source.size < offset + 6 + len) {
+            break;
+        }
+
+        const auto* frame = source.frame(offset, 6 + len, scratch.data());
+        auto response = parsePdu(frame + 6, len);
+        response.transactionId = static_cast<std::uint16_t>((frame[0] << 8) | frame[1]);
+        onResponse(response);
+        framesDecoded_.fetch_add(1, std::memory_order_relaxed);
+        offset += 6 + len;
     }
+    return offset;
+}
 
+template <typename Source>
+std::size_t ProtocolHandler::decodeRtu(const Source& source, const ResponseHandler& onResponse) {
+    std::array<std::uint8_t, transport::kMaxFrameSize> scratch;
     std::size_t offset = 0;
-    while (buffer.size() >= offset + 5) {
-        const std::uint8_t function = buffer[offset + 1];
+    while (source.size >= offset + 5) {
+        const std::uint8_t function = source.at(offset + 1);
 
         std::size_t frameLen = 0;
         if ((function & 0x80U) != 0U) {
             frameLen = 5; // slave + exception function + code + crc(2)
         } else if (function == static_cast<std::uint8_t>(FunctionCode::ReadHoldingRegisters) ||
                    function == static_cast<std::uint8_t>(FunctionCode::ReadInputRegisters)) {
-            const std::size_t byteCountIndex = offset + 2;
-            if (buffer.size() <= byteCountIndex) {
-                break;
-            }
-            const std::size_t byteCount = buffer[byteCountIndex];
+            const std::size_t byteCount = source.at(offset + 2);
             frameLen = 3 + byteCount + 2; // slave + func + byteCount + data + crc(2)
         } else if (function == static_cast<std::uint8_t>(FunctionCode::WriteSingleRegister) ||
                    function == static_cast<std::uint8_t>(FunctionCode::WriteMultipleRegisters)) {
@@ -168,46 +242,31 @@ std::vector<json::value> ProtocolHandler::processIncomingBuffer(
             continue;
         }
 
-        if (buffer.size() < offset + frameLen) {
+        if (source.size < offset + frameLen) {
             break;
         }
 
-        std::vector<std::uint8_t> frame(buffer.begin() + static_cast<std::ptrdiff_t>(offset),
-                                        buffer.begin() + static_cast<std::ptrdiff_t>(offset + frameLen));
-
+        const auto* frame = source.frame(offset, frameLen, scratch.data());
         const auto expected = static_cast<std::uint16_t>((frame[frameLen - 1] << 8) | frame[frameLen - 2]);
-        std::vector<std::uint8_t> pdu(frame.begin(), frame.end() - 2);
-        const auto actual = crc16(pdu);
-        if (actual != expected) {
+        if (MB::CRC::calculateCRC(frame, frameLen - 2) != expected) {
             ++offset;
             continue;
         }
 
-        result.push_back(responseToJson(parsePdu(pdu), requestId));
+        onResponse(parsePdu(frame, frameLen - 2));
+        framesDecoded_.fetch_add(1, std::memory_order_relaxed);
         offset += frameLen;
     }
-
-    if (offset > 0) {
-        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
-    }
-
-    return result;
+    return offset;
 }
 
-std::uint16_t ProtocolHandler::crc16(const std::vector<std::uint8_t>& data) {
-    std::uint16_t crc = 0xFFFF;
-    for (const auto b : data) {
-        crc ^= b;
-        for (int i = 0; i < 8; ++i) {
-            if ((crc & 0x01U) != 0U) {
-                crc >>= 1;
-                crc ^= 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
+void ProtocolHandler::storeTail(ByteRing& ring, const std::uint8_t* data, std::size_t size) {
+    if (size == 0) {
+        return;
     }
-    return crc;
+    const auto overflowBefore = ring.overflowBytes();
+    ring.write(data, size);
+    overflowBytes_.fetch_add(ring.overflowBytes() - overflowBefore, std::memory_order_relaxed);
 }
 
 std::string ProtocolHandler::functionToString(FunctionCode code) {
@@ -224,6 +283,30 @@ std::string ProtocolHandler::functionToString(FunctionCode code) {
     return "unknown";
 }
 
+std::string ProtocolHandler::exceptionToString(std::uint8_t exceptionCode) {
+    switch (exceptionCode) {
+        case 0x01:
+            return "illegal function";
+        case 0x02:
+            return "illegal data address";
+        case 0x03:
+            return "illegal data value";
+        case 0x04:
+            return "server device failure";
+        case 0x05:
+            return "acknowledge";
+        case 0x06:
+            return "server device busy";
+        case 0x08:
+            return "memory parity error";
+        case 0x0A:
+            return "gateway path unavailable";
+        case 0x0B:
+            return "gateway target device failed to respond";
+    }
+    return "unknown exception";
+}
+
 bool ProtocolHandler::parseFunction(const std::string& name, FunctionCode& code) {
     if (name == "read_holding") {
         code = FunctionCode::ReadHoldingRegisters;
@@ -244,37 +327,45 @@ bool ProtocolHandler::parseFunction(const std::string& name, FunctionCode& code)
     return false;
 }
 
-std::vector<std::uint8_t> ProtocolHandler::createPdu(const ModbusRequest& request) const {
-    std::vector<std::uint8_t> pdu;
-    pdu.push_back(request.slaveId);
-    pdu.push_back(static_cast<std::uint8_t>(request.function));
+std::size_t ProtocolHandler::pduSize(const ModbusRequest& request) noexcept {
+    // slave + function + address(2) + count/value(2) [+ byteCount + values]
+    if (request.function == FunctionCode::WriteMultipleRegisters) {
+        return 7 + request.values.size() * 2;
+    }
+    return 6;
+}
+
+std::size_t ProtocolHandler::encodePdu(const ModbusRequest& request, std::uint8_t* out) noexcept {
+    std::size_t pos = 0;
+    out[pos++] = request.slaveId;
+    out[pos++] = static_cast<std::uint8_t>(request.function);
 
-    pdu.push_back(static_cast<std::uint8_t>((request.startAddress >> 8) & 0xFF));
-    pdu.push_back(static_cast<std::uint8_t>(request.startAddress & 0xFF));
+    out[pos++] = static_cast<std::uint8_t>((request.startAddress >> 8) & 0xFF);
+    out[pos++] = static_cast<std::uint8_t>(request.startAddress & 0xFF);
 
     if (request.function == FunctionCode::WriteSingleRegister) {
         const auto value = request.values.empty() ? 0 : request.values.front();
-        pdu.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
-        pdu.push_back(static_cast<std::uint8_t>(value & 0xFF));
-        return pdu;
+        out[pos++] = static_cast<std::uint8_t>((value >> 8) & 0xFF);
+        out[pos++] = static_cast<std::uint8_t>(value & 0xFF);
+        return pos;
     }
 
-    pdu.push_back(static_cast<std::uint8_t>((request.count >> 8) & 0xFF));
-    pdu.push_back(static_cast<std::uint8_t>(request.count & 0xFF));
+    out[pos++] = static_cast<std::uint8_t>((request.count >> 8) & 0xFF);
+    out[pos++] = static_cast<std::uint8_t>(request.count & 0xFF);
 
     if (request.function == FunctionCode::WriteMultipleRegisters) {
-        pdu.push_back(static_cast<std::uint8_t>(request.values.size() * 2));
+        out[pos++] = static_cast<std::uint8_t>(request.values.size() * 2);
         for (const auto v : request.values) {
-            pdu.push_back(static_cast<std::uint8_t>((v >> 8) & 0xFF));
-            pdu.push_back(static_cast<std::uint8_t>(v & 0xFF));
+            out[pos++] = static_cast<std::uint8_t>((v >> 8) & 0xFF);
+            out[pos++] = static_cast<std::uint8_t>(v & 0xFF);
         }
     }
 
-    return pdu;
+    return pos;
 }
 
-ModbusResponse ProtocolHandler::parsePdu(const std::vector<std::uint8_t>& pdu) const {
-    if (pdu.size() < 2) {
+ModbusResponse ProtocolHandler::parsePdu(const std::uint8_t* pdu, std::size_t size) const {
+    if (size < 2) {
         throw std::runtime_error("PDU too short");
     }
 
@@ -285,17 +376,22 @@ ModbusResponse ProtocolHandler::parsePdu(const std::vector<std::uint8_t>& pdu) c
     const auto func = pdu[1];
     if ((func & 0x80U) != 0U) {
         response.isException = true;
-        response.exceptionCode = pdu.size() > 2 ? pdu[2] : 0;
+        response.exceptionCode = size > 2 ? pdu[2] : 0;
         return response;
     }
 
     if ((func == static_cast<std::uint8_t>(FunctionCode::ReadHoldingRegisters) ||
          func == static_cast<std::uint8_t>(FunctionCode::ReadInputRegisters)) &&
-        pdu.size() >= 3) {
+        size >= 3) {
         const auto byteCount = pdu[2];
-        for (std::size_t i = 0; i + 1 < byteCount && (3 + i + 1) < pdu.size(); i += 2) {
+        for (std::size_t i = 0; i + 1 < byteCount && (3 + i + 1) < size; i += 2) {
             response.values.push_back(static_cast<std::uint16_t>((pdu[3 + i] << 8) | pdu[3 + i + 1]));
         }
+    } else if ((func == static_cast<std::uint8_t>(FunctionCode::WriteSingleRegister) ||
+                func == static_cast<std::uint8_t>(FunctionCode::WriteMultipleRegisters)) &&
+               size >= 6) {
+        response.address = static_cast<std::uint16_t>((pdu[2] << 8) | pdu[3]);
+        response.quantity = static_cast<std::uint16_t>((pdu[4] << 8) | pdu[5]);
     }
 
     return response;
@@ -2,16 +2,25 @@
 
 #include <boost/json.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "ByteRing.h"
 #include "layers/transport/transport_layer.h"
 
 namespace protocol {
 
 namespace json = boost::json;
 
+// Register limits of a single request (Modbus application protocol, sections 6.3 and 6.12).
+inline constexpr std::uint16_t kMaxReadRegisters = 125;
+inline constexpr std::uint16_t kMaxWriteRegisters = 123;
+
 enum class FunctionCode : std::uint8_t {
     ReadHoldingRegisters = 0x03,
     ReadInputRegisters = 0x04,
@@ -25,37 +34,109 @@ struct ModbusRequest {
     std::uint16_t startAddress = 0;
     std::uint16_t count = 1;
     std::vector<std::uint16_t> values;
+    std::uint16_t transactionId = 0;
+};
+
+// Register values of one response, stored inline: a read returns at most 125 registers.
+class RegisterBlock {
+public:
+    void push_back(std::uint16_t value) noexcept {
+        if (size_ < values_.size()) {
+            values_[size_++] = value;
+        }
+    }
+    void clear() noexcept { size_ = 0; }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::uint16_t operator[](std::size_t index) const noexcept { return values_[index]; }
+    const std::uint16_t* data() const noexcept { return values_.data(); }
+    const std::uint16_t* begin() const noexcept { return values_.data(); }
+    const std::uint16_t* end() const noexcept { return values_.data() + size_; }
+
+private:
+    std::array<std::uint16_t, kMaxReadRegisters> values_{};
+    std::uint16_t size_ = 0;
 };
 
 struct ModbusResponse {
-    std::uint8_t slaveId = 0;
+    std::uint8_t slaveId = 0; // unit ID
     FunctionCode function = FunctionCode::ReadHoldingRegisters;
-    std::vector<std::uint16_t> values;
+    std::uint16_t transactionId = 0;
+    RegisterBlock values;     // read responses
+    std::uint16_t address = 0;  // write echoes: start address
+    std::uint16_t quantity = 0; // write echoes: value (FC06) or register count (FC16)
     bool isException = false;
     std::uint8_t exceptionCode = 0;
 };
 
+inline bool isReadFunction(FunctionCode code) noexcept {
+    return code == FunctionCode::ReadHoldingRegisters || code == FunctionCode::ReadInputRegisters;
+}
+
+struct ReceiveStats {
+    std::uint64_t framesDecoded = 0;
+    std::uint64_t bytesReceived = 0;
+    // Bytes discarded because a reassembly ring overflowed.
+    std::uint64_t overflowBytes = 0;
+    // Stream decoders (each with its reassembly ring) created, one per opened session.
+    std::uint64_t decodersCreated = 0;
+};
+
+// Reassembly ring size per stream: a full 2 KiB read plus a partial frame, rounded up.
+inline constexpr std::size_t kReassemblyCapacity = 4096;
+
+// Reassembly state of one transport session. Created when the session is opened and only
+// used from that session's io thread, so sessions are decoded in parallel without locking.
+class StreamDecoder : public transport::SessionContext {
+public:
+    explicit StreamDecoder(transport::ConnectionType connectionType);
+
+    transport::ConnectionType connectionType() const noexcept { return connectionType_; }
+
+private:
+    friend class ProtocolHandler;
+
+    transport::ConnectionType connectionType_;
+    ByteRing ring_{kReassemblyCapacity};
+};
+
 class ProtocolHandler {
 public:
     bool jsonToRequest(const json::value& payload, ModbusRequest& out, std::string& error) const;
     json::value responseToJson(const ModbusResponse& response, std::int64_t requestId) const;
 
-    std::vector<std::uint8_t> createFrame(const ModbusRequest& request, transport::ConnectionType connectionType) const;
-    std::vector<json::value> processIncomingBuffer(
-        const std::vector<std::uint8_t>& chunk,
-        transport::ConnectionType connectionType,
-        std::int64_t requestId);
+    // Encodes the ADU straight into a pooled transmit buffer; fails if the request does not fit one frame.
+    bool encodeFrame(const ModbusRequest& request, transport::ConnectionType connectionType,
+                     transport::FrameBuffer& out, std::string& error) const;
+    using ResponseHandler = std::function<void(const ModbusResponse&)>;
+
+    std::unique_ptr<StreamDecoder> createDecoder(transport::ConnectionType connectionType);
+    // Decodes every complete frame in place and reports it as a typed response; no JSON is built here.
+    void processIncomingBuffer(StreamDecoder& decoder, transport::ByteSpan chunk, const ResponseHandler& onResponse);
 
-private:
-    static std::uint16_t crc16(const std::vector<std::uint8_t>& data);
     static std::string functionToString(FunctionCode code);
+    static std::string exceptionToString(std::uint8_t exceptionCode);
+
+    ReceiveStats receiveStats() const noexcept;
+
+private:
     static bool parseFunction(const std::string& name, FunctionCode& code);
 
-    std::vector<std::uint8_t> createPdu(const ModbusRequest& request) const;
-    ModbusResponse parsePdu(const std::vector<std::uint8_t>& pdu) const;
+    static std::size_t pduSize(const ModbusRequest& request) noexcept;
+    static std::size_t encodePdu(const ModbusRequest& request, std::uint8_t* out) noexcept;
+    ModbusResponse parsePdu(const std::uint8_t* pdu, std::size_t size) const;
+
+    template <typename Source>
+    std::size_t decodeTcp(const Source& source, const ResponseHandler& onResponse);
+    template <typename Source>
+    std::size_t decodeRtu(const Source& source, const ResponseHandler& onResponse);
+    void storeTail(ByteRing& ring, const std::uint8_t* data, std::size_t size);
 
-    std::vector<std::uint8_t> tcpBuffer_;
-    std::vector<std::uint8_t> rtuBuffer_;
+    std::atomic<std::uint64_t> framesDecoded_{0};
+    std::atomic<std::uint64_t> bytesReceived_{0};
+    std::atomic<std::uint64_t> overflowBytes_{0};
+    std::atomic<std::uint64_t> decodersCreated_{0};
 };
 
 } // namespace protocol
@@ -1,6 +1,9 @@
 #include "transport_layer.h"
 
+#include <algorithm>
+#include <future>
 #include <sstream>
+#include <stdexcept>
 
 namespace transport {
 
@@ -15,6 +18,48 @@ void closeStream(Stream& stream) {
 
 } // namespace
 
+void FrameReleaser::operator()(FrameBuffer* frame) const noexcept {
+    if (pool) {
+        pool->release(frame);
+    } else {
+        delete frame;
+    }
+}
+
+FramePool::FramePool(std::size_t maxIdle)
+    : maxIdle_(maxIdle) {
+    idle_.reserve(maxIdle_);
+}
+
+FramePtr FramePool::acquire() {
+    std::unique_ptr<FrameBuffer> frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            frame = std::move(idle_.back());
+            idle_.pop_back();
+        }
+    }
+    if (!frame) {
+        frame = std::make_unique<FrameBuffer>();
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    frame->resize(0);
+    return FramePtr(frame.release(), FrameReleaser{shared_from_this()});
+}
+
+std::uint64_t FramePool::allocations() const noexcept {
+    return allocations_.load(std::memory_order_relaxed);
+}
+
+void FramePool::release(FrameBuffer* frame) noexcept {
+    std::unique_ptr<FrameBuffer> owned(frame);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.size() < maxIdle_) {
+        idle_.push_back(std::move(owned));
+    }
+}
+
 Session::Session(std::uint64_t id, tcp::socket socket)
     : id_(id), stream_(std::move(socket)) {}
 
@@ -27,22 +72,55 @@ ConnectionType Session::connectionType() const noexcept {
     return std::holds_alternative<tcp::socket>(stream_) ? ConnectionType::Tcp : ConnectionType::Rtu;
 }
 
+std::uint16_t Session::nextTransactionId() noexcept {
+    return nextTransactionId_.fetch_add(1, std::memory_order_relaxed);
+}
+
+SessionStats Session::stats() const noexcept {
+    SessionStats stats;
+    stats.sessionId = id_;
+    stats.type = connectionType();
+    stats.framesWritten = framesWritten_.load(std::memory_order_relaxed);
+    stats.writeCalls = writeCalls_.load(std::memory_order_relaxed);
+    stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    stats.readCalls = readCalls_.load(std::memory_order_relaxed);
+    stats.bytesRead = bytesRead_.load(std::memory_order_relaxed);
+    stats.frameAllocations = framePool_->allocations();
+    return stats;
+}
+
+FramePtr Session::acquireFrame() {
+    return framePool_->acquire();
+}
+
+void Session::setContext(std::unique_ptr<SessionContext> context) noexcept {
+    context_ = std::move(context);
+}
+
+SessionContext* Session::context() const noexcept {
+    return context_.get();
+}
+
+void Session::setMaxWriteBytes(std::size_t bytes) noexcept {
+    maxWriteBytes_ = std::max<std::size_t>(bytes, 1);
+}
+
 void Session::start(FrameCallback onFrame, ErrorCallback onError) {
     onFrame_ = std::move(onFrame);
     onError_ = std::move(onError);
     doRead();
 }
 
-void Session::send(const std::vector<uint8_t>& data, ErrorCallback onError) {
-    if (data.empty() || closed_) {
+void Session::send(FramePtr frame, ErrorCallback onError) {
+    if (!frame || frame->size() == 0 || closed_) {
         return;
     }
 
     auto self = shared_from_this();
     boost::asio::post(std::visit([](auto& stream) { return stream.get_executor(); }, stream_),
-        [this, self, payload = std::vector<uint8_t>(data), onError = std::move(onError)]() mutable {
+        [this, self, frame = std::move(frame), onError = std::move(onError)]() mutable {
             const bool writeInProgress = !writeQueue_.empty();
-            writeQueue_.push_back(std::move(payload));
+            writeQueue_.push_back(std::move(frame));
             if (!writeInProgress) {
                 doWrite();
             }
@@ -76,9 +154,13 @@ void Session::doRead() {
                         return;
                     }
 
-                    std::vector<uint8_t> frame(readBuffer_.begin(), readBuffer_.begin() + bytesRead);
+                    readCalls_.fetch_add(1, std::memory_order_relaxed);
+                    bytesRead_.fetch_add(bytesRead, std::memory_order_relaxed);
+
+                    // The parser reads straight out of readBuffer_: nothing touches it until the next
+                    // async_read_some, which is only started after the callback returns.
                     if (onFrame_) {
-                        onFrame_(frame, self);
+                        onFrame_(ByteSpan{readBuffer_.data(), bytesRead}, self);
                     }
                     doRead();
                 });
@@ -91,13 +173,25 @@ void Session::doWrite() {
         return;
     }
 
+    // Gather every queued frame (up to maxWriteBytes_) into one write; the frames stay in
+    // writeQueue_ until it completes so send() keeps appending behind them.
+    writeBatch_.clear();
+    std::size_t batchBytes = 0;
+    for (const auto& frame : writeQueue_) {
+        if (!writeBatch_.empty() && batchBytes + frame->size() > maxWriteBytes_) {
+            break;
+        }
+        writeBatch_.push_back(boost::asio::buffer(frame->data(), frame->size()));
+        batchBytes += frame->size();
+    }
+
     auto self = shared_from_this();
     std::visit(
         [this, self](auto& stream) {
             boost::asio::async_write(
                 stream,
-                boost::asio::buffer(writeQueue_.front()),
-                [this, self](const boost::system::error_code& ec, std::size_t) {
+                writeBatch_,
+                [this, self, frames = writeBatch_.size()](const boost::system::error_code& ec, std::size_t bytesWritten) {
                     if (ec) {
                         closed_ = true;
                         if (ec != boost::asio::error::operation_aborted && onError_) {
@@ -106,69 +200,210 @@ void Session::doWrite() {
                         return;
                     }
 
-                    writeQueue_.pop_front();
+                    writeCalls_.fetch_add(1, std::memory_order_relaxed);
+                    framesWritten_.fetch_add(frames, std::memory_order_relaxed);
+                    bytesWritten_.fetch_add(bytesWritten, std::memory_order_relaxed);
+
+                    writeQueue_.erase(writeQueue_.begin(), writeQueue_.begin() + static_cast<std::ptrdiff_t>(frames));
                     doWrite();
                 });
         },
         stream_);
 }
 
-TransportManager::TransportManager()
-    : workGuard_(boost::asio::make_work_guard(ioContext_)),
-      ioThread_([this]() { ioContext_.run(); }) {}
+TransportManager::IoWorker::IoWorker()
+    : workGuard(boost::asio::make_work_guard(ioContext)),
+      thread([this]() { ioContext.run(); }) {}
+
+TransportManager::TransportManager(TransportOptions options)
+    : options_(options) {
+    const auto threads = std::max<std::size_t>(options_.ioThreads, 1);
+    ioWorkers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        ioWorkers_.push_back(std::make_unique<IoWorker>());
+    }
+}
 
 TransportManager::~TransportManager() {
     disconnectAll();
-    workGuard_.reset();
-    ioContext_.stop();
-    if (ioThread_.joinable()) {
-        ioThread_.join();
+    for (auto& worker : ioWorkers_) {
+        worker->workGuard.reset();
+        worker->ioContext.stop();
+    }
+    for (auto& worker : ioWorkers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
     }
 }
 
-SessionPtr TransportManager::connectTcpSlave(const std::string& ip, std::uint16_t port) {
-    try {
-        tcp::socket socket(ioContext_);
-        socket.connect({boost::asio::ip::make_address(ip), port});
+boost::asio::io_context& TransportManager::contextForSession(std::uint64_t sessionId) {
+    const auto index = std::hash<std::uint64_t>{}(sessionId) % ioWorkers_.size();
+    return ioWorkers_[index]->ioContext;
+}
 
-        auto session = std::make_shared<Session>(nextSessionId_++, std::move(socket));
-        {
-            std::lock_guard<std::mutex> lock(sessionsMutex_);
-            sessions_.emplace(session->id(), session);
-        }
-        session->start(onFrame_, [this](const std::string& error) { notifyError(error); });
-        notifyConnected(session);
-        return session;
-    } catch (const std::exception& e) {
-        notifyError(std::string("TCP connect error: ") + e.what());
-        return nullptr;
+void TransportManager::registerSession(const SessionPtr& session) {
+    session->setMaxWriteBytes(options_.maxWriteBytes);
+    if (contextFactory_) {
+        session->setContext(contextFactory_(*session));
     }
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        sessions_.emplace(session->id(), session);
+    }
+    session->start(onFrame_, [this](const std::string& error) { notifyError(error); });
+    notifyConnected(session);
 }
 
-SessionPtr TransportManager::connectSerialSlave(const std::string& portName, std::uint32_t baudRate) {
+void TransportManager::asyncConnectTcpSlave(const std::string& ip, std::uint16_t port, std::chrono::milliseconds timeout,
+                                            ConnectHandler handler) {
+    struct ConnectAttempt {
+        ConnectAttempt(boost::asio::io_context& context, std::chrono::milliseconds timeout)
+            : socket(context), timer(context, timeout) {}
+
+        tcp::socket socket;
+        boost::asio::steady_timer timer;
+        bool timedOut = false;
+    };
+
+    const auto sessionId = nextSessionId_++;
+    auto& context = contextForSession(sessionId);
+
+    boost::system::error_code ec;
+    const auto address = boost::asio::ip::make_address(ip, ec);
+    if (ec) {
+        const auto error = std::string("TCP connect error: invalid address ") + ip;
+        notifyError(error);
+        boost::asio::post(context, [handler = std::move(handler), error]() { handler(nullptr, error); });
+        return;
+    }
+
+    auto attempt = std::make_shared<ConnectAttempt>(context, timeout);
+    attempt->timer.async_wait([attempt](const boost::system::error_code& timerEc) {
+        if (timerEc) {
+            return;
+        }
+        attempt->timedOut = true;
+        boost::system::error_code ignored;
+        attempt->socket.close(ignored);
+    });
+
+    attempt->socket.async_connect(
+        tcp::endpoint{address, port},
+        [this, attempt, sessionId, ip, port, timeout, handler = std::move(handler)](const boost::system::error_code& connectEc) {
+            attempt->timer.cancel();
+            if (connectEc || attempt->timedOut) {
+                const auto error = attempt->timedOut
+                                       ? "TCP connect error: " + ip + ':' + std::to_string(port) + " timed out after " +
+                                             std::to_string(timeout.count()) + " ms"
+                                       : "TCP connect error: " + connectEc.message();
+                notifyError(error);
+                handler(nullptr, error);
+                return;
+            }
+
+            auto session = std::make_shared<Session>(sessionId, std::move(attempt->socket));
+            registerSession(session);
+            handler(session, {});
+        });
+}
+
+void TransportManager::asyncConnectSerialSlave(const std::string& portName, std::uint32_t baudRate,
+                                               std::chrono::milliseconds timeout, ConnectHandler handler) {
+    struct OpenAttempt {
+        OpenAttempt(boost::asio::io_context& context, std::chrono::milliseconds timeout)
+            : port(context), timer(context, timeout) {}
+
+        boost::asio::serial_port port;
+        boost::asio::steady_timer timer;
+        std::string error;
+        bool finished = false;  // touched on the session's io thread only
+    };
+
+    const auto sessionId = nextSessionId_++;
+    auto& context = contextForSession(sessionId);
+    auto attempt = std::make_shared<OpenAttempt>(context, timeout);
+    auto sharedHandler = std::make_shared<ConnectHandler>(std::move(handler));
+
+    attempt->timer.async_wait([this, attempt, sharedHandler, portName, timeout](const boost::system::error_code& timerEc) {
+        if (timerEc || attempt->finished) {
+            return;
+        }
+        attempt->finished = true;
+        const auto error = "Serial connect error: open of " + portName + " timed out after " +
+                           std::to_string(timeout.count()) + " ms";
+        notifyError(error);
+        (*sharedHandler)(nullptr, error);
+    });
+
+    // Opening a serial port blocks and cannot be cancelled, so it runs off the io threads; the
+    // result is handed back to the session's io thread and raced against the timer there.
+    boost::asio::post(blockingPool_, [this, &context, attempt, sharedHandler, sessionId, portName, baudRate]() {
+        try {
+            attempt->port.open(portName);
+            attempt->port.set_option(boost::asio::serial_port_base::baud_rate(baudRate));
+            attempt->port.set_option(boost::asio::serial_port_base::character_size(8));
+            attempt->port.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none));
+            attempt->port.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one));
+        } catch (const std::exception& e) {
+            attempt->error = std::string("Serial connect error: ") + e.what();
+        }
+
+        boost::asio::post(context, [this, attempt, sharedHandler, sessionId]() {
+            attempt->timer.cancel();
+            if (attempt->finished) {
+                // The caller has already been told it timed out; do not keep the port open.
+                boost::system::error_code ignored;
+                attempt->port.close(ignored);
+                return;
+            }
+            attempt->finished = true;
+            if (!attempt->error.empty()) {
+                notifyError(attempt->error);
+                (*sharedHandler)(nullptr, attempt->error);
+                return;
+            }
+
+            auto session = std::make_shared<Session>(sessionId, std::move(attempt->port));
+            registerSession(session);
+            (*sharedHandler)(session, {});
+        });
+    });
+}
+
+SessionPtr TransportManager::waitForConnect(const std::function<void(ConnectHandler)>& start, std::string* error) {
+    auto promise = std::make_shared<std::promise<std::pair<SessionPtr, std::string>>>();
+    auto future = promise->get_future();
+    start([promise](const SessionPtr& session, const std::string& connectError) {
+        promise->set_value({session, connectError});
+    });
     try {
-        boost::asio::serial_port port(ioContext_);
-        port.open(portName);
-        port.set_option(boost::asio::serial_port_base::baud_rate(baudRate));
-        port.set_option(boost::asio::serial_port_base::character_size(8));
-        port.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none));
-        port.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one));
-
-        auto session = std::make_shared<Session>(nextSessionId_++, std::move(port));
-        {
-            std::lock_guard<std::mutex> lock(sessionsMutex_);
-            sessions_.emplace(session->id(), session);
+        auto [session, connectError] = future.get();
+        if (error) {
+            *error = std::move(connectError);
         }
-        session->start(onFrame_, [this](const std::string& error) { notifyError(error); });
-        notifyConnected(session);
         return session;
-    } catch (const std::exception& e) {
-        notifyError(std::string("Serial connect error: ") + e.what());
+    } catch (const std::future_error&) {
+        if (error) {
+            *error = "Transport stopped before the connect completed";
+        }
         return nullptr;
     }
 }
 
-void TransportManager::sendToSession(const std::vector<uint8_t>& data, const SessionPtr& session) {
+SessionPtr TransportManager::connectTcpSlave(const std::string& ip, std::uint16_t port, std::chrono::milliseconds timeout,
+                                             std::string* error) {
+    return waitForConnect([&](ConnectHandler handler) { asyncConnectTcpSlave(ip, port, timeout, std::move(handler)); },
+                          error);
+}
+
+SessionPtr TransportManager::connectSerialSlave(const std::string& portName, std::uint32_t baudRate,
+                                                std::chrono::milliseconds timeout, std::string* error) {
+    return waitForConnect(
+        [&](ConnectHandler handler) { asyncConnectSerialSlave(portName, baudRate, timeout, std::move(handler)); }, error);
+}
+
+void TransportManager::sendToSession(FramePtr frame, const SessionPtr& session) {
     if (!session) {
         notifyError("Cannot send: session is null");
         return;
@@ -181,7 +416,7 @@ void TransportManager::sendToSession(const std::vector<uint8_t>& data, const Ses
         return;
     }
 
-    it->second->send(data, [this](const std::string& error) { notifyError(error); });
+    it->second->send(std::move(frame), [this](const std::string& error) { notifyError(error); });
 }
 
 void TransportManager::disconnectSession(std::uint64_t sessionId) {
@@ -242,6 +477,7 @@ std::vector<SessionPtr> TransportManager::getAllConnections() const {
 void TransportManager::setFrameCallback(FrameCallback cb) { onFrame_ = std::move(cb); }
 void TransportManager::setConnectionCallback(ConnectionCallback cb) { onConnection_ = std::move(cb); }
 void TransportManager::setErrorCallback(ErrorCallback cb) { onError_ = std::move(cb); }
+void TransportManager::setSessionContextFactory(SessionContextFactory factory) { contextFactory_ = std::move(factory); }
 
 void TransportManager::notifyConnected(const SessionPtr& session) {
     if (onConnection_) {
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -25,11 +26,96 @@ enum class ConnectionType {
     Rtu
 };
 
+// Non-owning view over received bytes; only valid for the duration of the frame callback.
+struct ByteSpan {
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+
+    const std::uint8_t* begin() const noexcept { return data; }
+    const std::uint8_t* end() const noexcept { return data + size; }
+    std::uint8_t operator[](std::size_t index) const noexcept { return data[index]; }
+    bool empty() const noexcept { return size == 0; }
+};
+
+// Largest Modbus ADU: 7-byte MBAP header + 253-byte PDU (an RTU ADU is at most 256 bytes).
+inline constexpr std::size_t kMaxFrameSize = 260;
+
+class FrameBuffer {
+public:
+    static constexpr std::size_t kCapacity = kMaxFrameSize;
+
+    std::uint8_t* data() noexcept { return bytes_.data(); }
+    const std::uint8_t* data() const noexcept { return bytes_.data(); }
+    std::size_t size() const noexcept { return size_; }
+    void resize(std::size_t size) noexcept { size_ = size < kCapacity ? size : kCapacity; }
+
+private:
+    std::array<std::uint8_t, kCapacity> bytes_{};
+    std::size_t size_ = 0;
+};
+
+class FramePool;
+
+// Returns the buffer to its pool instead of freeing it.
+struct FrameReleaser {
+    std::shared_ptr<FramePool> pool;
+    void operator()(FrameBuffer* frame) const noexcept;
+};
+
+using FramePtr = std::unique_ptr<FrameBuffer, FrameReleaser>;
+
+// Free list of fixed-size frame buffers. Acquire and release may happen on different threads.
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+    explicit FramePool(std::size_t maxIdle = 64);
+
+    FramePtr acquire();
+    std::uint64_t allocations() const noexcept;
+
+private:
+    friend struct FrameReleaser;
+    void release(FrameBuffer* frame) noexcept;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<FrameBuffer>> idle_;
+    std::size_t maxIdle_;
+    std::atomic<std::uint64_t> allocations_{0};
+};
+
+// Per-session state owned by an upper layer (e.g. the protocol reassembler). It is attached
+// before the session starts reading and only touched from the session's io thread.
+class SessionContext {
+public:
+    virtual ~SessionContext() = default;
+};
+
 class Session;
 using SessionPtr = std::shared_ptr<Session>;
-using FrameCallback = std::function<void(const std::vector<uint8_t>&, const SessionPtr&)>;
+using FrameCallback = std::function<void(ByteSpan, const SessionPtr&)>;
 using ConnectionCallback = std::function<void(bool connected, const SessionPtr&)>;
+using SessionContextFactory = std::function<std::unique_ptr<SessionContext>(const Session&)>;
 using ErrorCallback = std::function<void(const std::string&)>;
+// Invoked on the session's io thread: session is null and error is set when the connect failed.
+using ConnectHandler = std::function<void(const SessionPtr& session, const std::string& error)>;
+
+inline constexpr std::chrono::milliseconds kDefaultConnectTimeout{3000};
+
+struct SessionStats {
+    std::uint64_t sessionId = 0;
+    ConnectionType type = ConnectionType::Tcp;
+    std::uint64_t framesWritten = 0;
+    std::uint64_t writeCalls = 0;
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t readCalls = 0;
+    std::uint64_t bytesRead = 0;
+    std::uint64_t frameAllocations = 0;
+
+    double framesPerWrite() const noexcept {
+        return writeCalls == 0 ? 0.0 : static_cast<double>(framesWritten) / static_cast<double>(writeCalls);
+    }
+};
+
+inline constexpr std::size_t kDefaultMaxWriteBytes = 8192;
 
 class Session : public std::enable_shared_from_this<Session> {
 public:
@@ -38,9 +124,20 @@ public:
 
     std::uint64_t id() const noexcept;
     ConnectionType connectionType() const noexcept;
+    std::uint16_t nextTransactionId() noexcept;
+    SessionStats stats() const noexcept;
+
+    // Pooled transmit buffer; fill it and hand it back through send().
+    FramePtr acquireFrame();
+
+    void setContext(std::unique_ptr<SessionContext> context) noexcept;
+    SessionContext* context() const noexcept;
+
+    // Upper bound for one gathered write; a single frame larger than this is still sent whole.
+    void setMaxWriteBytes(std::size_t bytes) noexcept;
 
     void start(FrameCallback onFrame, ErrorCallback onError);
-    void send(const std::vector<uint8_t>& data, ErrorCallback onError);
+    void send(FramePtr frame, ErrorCallback onError);
     void close();
 
 private:
@@ -50,24 +147,52 @@ private:
     std::uint64_t id_;
     std::variant<tcp::socket, boost::asio::serial_port> stream_;
     std::array<std::uint8_t, 2048> readBuffer_{};
-    std::deque<std::vector<std::uint8_t>> writeQueue_;
+    std::unique_ptr<SessionContext> context_;
+    std::shared_ptr<FramePool> framePool_ = std::make_shared<FramePool>();
+    std::vector<FramePtr> writeQueue_;
+    std::vector<boost::asio::const_buffer> writeBatch_;
+    std::size_t maxWriteBytes_ = kDefaultMaxWriteBytes;
     FrameCallback onFrame_;
     ErrorCallback onError_;
-    bool closed_ = false;
+    std::atomic<bool> closed_{false};  // set by close() on any thread, read by the io handlers
+    std::atomic<std::uint16_t> nextTransactionId_{1};
+
+    std::atomic<std::uint64_t> framesWritten_{0};
+    std::atomic<std::uint64_t> writeCalls_{0};
+    std::atomic<std::uint64_t> bytesWritten_{0};
+    std::atomic<std::uint64_t> readCalls_{0};
+    std::atomic<std::uint64_t> bytesRead_{0};
+};
+
+struct TransportOptions {
+    // Number of io_context threads. Every session is pinned to one of them by hash of its id,
+    // so reads, writes and frame callbacks of a single session are never run concurrently.
+    std::size_t ioThreads = 1;
+    // Cap for coalescing queued frames into one scatter/gather write.
+    std::size_t maxWriteBytes = kDefaultMaxWriteBytes;
 };
 
 class TransportManager {
 public:
-    TransportManager();
+    explicit TransportManager(TransportOptions options = {});
     ~TransportManager();
 
     TransportManager(const TransportManager&) = delete;
     TransportManager& operator=(const TransportManager&) = delete;
 
-    SessionPtr connectTcpSlave(const std::string& ip, std::uint16_t port);
-    SessionPtr connectSerialSlave(const std::string& portName, std::uint32_t baudRate = 9600);
+    // Non-blocking connects bounded by a deadline; any number of them may run in parallel.
+    void asyncConnectTcpSlave(const std::string& ip, std::uint16_t port, std::chrono::milliseconds timeout,
+                              ConnectHandler handler);
+    void asyncConnectSerialSlave(const std::string& portName, std::uint32_t baudRate, std::chrono::milliseconds timeout,
+                                 ConnectHandler handler);
+
+    // Blocking wrappers over the async API. Must not be called from a transport io thread.
+    SessionPtr connectTcpSlave(const std::string& ip, std::uint16_t port,
+                               std::chrono::milliseconds timeout = kDefaultConnectTimeout, std::string* error = nullptr);
+    SessionPtr connectSerialSlave(const std::string& portName, std::uint32_t baudRate = 9600,
+                                  std::chrono::milliseconds timeout = kDefaultConnectTimeout, std::string* error = nullptr);
 
-    void sendToSession(const std::vector<uint8_t>& data, const SessionPtr& session);
+    void sendToSession(FramePtr frame, const SessionPtr& session);
     void disconnectSession(std::uint64_t sessionId);
     void disconnectAll();
 
@@ -78,15 +203,31 @@ public:
     void setFrameCallback(FrameCallback cb);
     void setConnectionCallback(ConnectionCallback cb);
     void setErrorCallback(ErrorCallback cb);
+    void setSessionContextFactory(SessionContextFactory factory);
 
 private:
     void notifyConnected(const SessionPtr& session);
     void notifyDisconnected(const SessionPtr& session);
     void notifyError(const std::string& error) const;
 
-    boost::asio::io_context ioContext_;
-    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> workGuard_;
-    std::thread ioThread_;
+    TransportOptions options_;
+
+    struct IoWorker {
+        IoWorker();
+
+        boost::asio::io_context ioContext;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> workGuard;
+        std::thread thread;
+    };
+
+    boost::asio::io_context& contextForSession(std::uint64_t sessionId);
+    void registerSession(const SessionPtr& session);
+    static SessionPtr waitForConnect(const std::function<void(ConnectHandler)>& start, std::string* error);
+
+    std::vector<std::unique_ptr<IoWorker>> ioWorkers_;
+    // Serial opens block; they run here so a slow driver does not stall the sessions of an io thread.
+    // Declared after the io workers so it is joined before their contexts go away.
+    boost::asio::thread_pool blockingPool_{2};
 
     mutable std::mutex sessionsMutex_;
     std::unordered_map<std::uint64_t, SessionPtr> sessions_;
@@ -95,6 +236,7 @@ private:
     FrameCallback onFrame_;
     ConnectionCallback onConnection_;
     ErrorCallback onError_;
+    SessionContextFactory contextFactory_;
 };
 
 } // namespace transport
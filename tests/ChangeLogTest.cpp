@@ -0,0 +1,135 @@
+#include "Check.h"
+#include "layers/application/RegisterCache.h"
+
+namespace {
+
+using application::RegisterCache;
+using protocol::FunctionCode;
+
+void store(RegisterCache& cache, std::uint16_t address, std::vector<std::uint16_t> values, std::uint8_t slave = 1,
+           FunctionCode function = FunctionCode::ReadHoldingRegisters) {
+    cache.store(slave, function, address, values.data(), values.size());
+}
+
+void followsTheCursor() {
+    RegisterCache cache;
+    const auto empty = cache.changesSince(0, 100);
+    CHECK(empty.changes.empty());
+    CHECK(empty.cursor == 0);
+    CHECK(!empty.reset && !empty.more);
+
+    store(cache, 10, {1, 2, 3});
+    const auto first = cache.changesSince(0, 100);
+    CHECK(first.changes.size() == 3);
+    CHECK(first.cursor == 3);
+    CHECK(first.changes[0].address == 10 && first.changes[0].value == 1);
+    CHECK(first.changes[2].sequence == 3);
+
+    store(cache, 11, {9});
+    const auto second = cache.changesSince(first.cursor, 100);
+    CHECK(second.changes.size() == 1);
+    CHECK(second.changes[0].address == 11 && second.changes[0].value == 9);
+    CHECK(second.cursor == 4);
+    CHECK(cache.changesSince(second.cursor, 100).changes.empty());
+}
+
+void unchangedValuesAreNotLogged() {
+    RegisterCache cache;
+    store(cache, 0, {5, 6});
+    store(cache, 0, {5, 6});
+    CHECK(cache.changeSequence() == 2);
+    store(cache, 0, {5, 7});
+    CHECK(cache.changeSequence() == 3);
+
+    // clear() forgets the values, so the next store logs them again; earlier cursors stay valid.
+    cache.clear();
+    store(cache, 0, {5});
+    const auto set = cache.changesSince(3, 100);
+    CHECK(!set.reset);
+    CHECK(set.changes.size() == 1 && set.changes[0].value == 5);
+}
+
+void keepsTheLatestValuePerRegister() {
+    RegisterCache cache;
+    store(cache, 0, {1});
+    store(cache, 1, {1});
+    store(cache, 0, {2});
+    store(cache, 0, {3}, 2);                                    // same address, another slave
+    store(cache, 0, {4}, 1, FunctionCode::ReadInputRegisters);  // same address, another table
+
+    const auto set = cache.changesSince(0, 100);
+    CHECK(set.changes.size() == 4);
+    CHECK(set.changes[0].address == 0 && set.changes[0].value == 2);
+    CHECK(set.changes[1].address == 1);
+    CHECK(set.changes[2].slaveId == 2);
+    CHECK(set.changes[3].table == FunctionCode::ReadInputRegisters);
+    CHECK(set.cursor == 5);
+}
+
+void limitSetsMore() {
+    RegisterCache cache;
+    store(cache, 0, {1});
+    store(cache, 1, {1});
+    store(cache, 0, {2});  // folds into the first entry, so it does not count against the limit
+    store(cache, 2, {1});
+
+    const auto first = cache.changesSince(0, 2);
+    CHECK(first.more);
+    CHECK(first.changes.size() == 2);
+    CHECK(first.changes[0].value == 2);
+    CHECK(first.cursor == 3);
+
+    const auto rest = cache.changesSince(first.cursor, 2);
+    CHECK(!rest.more);
+    CHECK(rest.changes.size() == 1 && rest.changes[0].address == 2);
+    CHECK(rest.cursor == 4);
+
+    // A limit of zero still makes progress.
+    const auto one = cache.changesSince(0, 0);
+    CHECK(one.changes.size() == 1 && one.more);
+}
+
+void resetsWhenTheCursorFellOutOfTheLog() {
+    RegisterCache cache;
+    cache.setChangeLogCapacity(4);
+    store(cache, 0, {1, 2, 3, 4, 5, 6});
+    CHECK(cache.changeLogSize() == 4);
+
+    // Entries 1 and 2 are gone, so a cursor of 0 or 1 would miss changes; 2 still connects.
+    const auto stale = cache.changesSince(1, 100);
+    CHECK(stale.reset);
+    CHECK(stale.changes.empty());
+    CHECK(stale.cursor == 6);
+
+    const auto connected = cache.changesSince(2, 100);
+    CHECK(!connected.reset);
+    CHECK(connected.changes.size() == 4);
+    CHECK(connected.changes[0].address == 2);
+
+    cache.setChangeLogCapacity(2);
+    CHECK(cache.changeLogSize() == 2);
+    CHECK(cache.changesSince(2, 100).reset);
+}
+
+void resetsOnAFutureCursor() {
+    RegisterCache cache;
+    store(cache, 0, {1});
+
+    // A cursor from an earlier run of the server can be ahead of this one.
+    const auto set = cache.changesSince(100, 10);
+    CHECK(set.reset);
+    CHECK(set.cursor == 1);
+    CHECK(!cache.changesSince(set.cursor, 10).reset);
+}
+
+} // namespace
+
+int main() {
+    followsTheCursor();
+    unchangedValuesAreNotLogged();
+    keepsTheLatestValuePerRegister();
+    limitSetsMore();
+    resetsWhenTheCursorFellOutOfTheLog();
+    resetsOnAFutureCursor();
+    return tests::result("ChangeLogTest");
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the unit tests, so they need nothing beyond the project's own dependencies.
+// A failed CHECK is reported and the test keeps going; main returns tests::result() as its exit code.
+namespace tests {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool ok, const char* expression, const char* file, int line) {
+    if (!ok) {
+        ++failures();
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    }
+}
+
+inline int result(const char* name) {
+    if (failures() != 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, failures());
+        return 1;
+    }
+    std::printf("%s: ok\n", name);
+    return 0;
+}
+
+} // namespace tests
+
+#define CHECK(expression) ::tests::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
@@ -0,0 +1,179 @@
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <array>
+#include <future>
+#include <thread>
+
+#include "Check.h"
+#include "layers/application/Coroutines.h"
+
+namespace {
+
+using application::ApplicationCore;
+using protocol::FunctionCode;
+using protocol::ModbusRequest;
+using tcp = boost::asio::ip::tcp;
+
+// A Modbus/TCP slave on a loopback port that answers register reads with address + index and
+// echoes single-register writes, until the client disconnects.
+class FakeSlave {
+public:
+    FakeSlave() : acceptor_(context_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+        thread_ = std::thread([this]() { serve(); });
+    }
+
+    ~FakeSlave() { thread_.join(); }
+
+    std::uint16_t port() const { return acceptor_.local_endpoint().port(); }
+
+private:
+    void serve() {
+        tcp::socket socket(context_);
+        acceptor_.accept(socket);
+        boost::system::error_code ec;
+        for (;;) {
+            std::array<std::uint8_t, 260> request{};
+            boost::asio::read(socket, boost::asio::buffer(request.data(), 7), ec);
+            const std::size_t length = (request[4] << 8) | request[5];
+            if (ec || length < 2 || length > request.size() - 6) {
+                return;
+            }
+            boost::asio::read(socket, boost::asio::buffer(request.data() + 7, length - 1), ec);
+            if (ec) {
+                return;
+            }
+
+            std::vector<std::uint8_t> response(request.begin(), request.begin() + 8);
+            if (request[7] == static_cast<std::uint8_t>(FunctionCode::WriteSingleRegister)) {
+                response.insert(response.end(), request.begin() + 8, request.begin() + 12);
+            } else {
+                const auto address = static_cast<std::uint16_t>((request[8] << 8) | request[9]);
+                const auto count = static_cast<std::uint16_t>((request[10] << 8) | request[11]);
+                response.push_back(static_cast<std::uint8_t>(count * 2));
+                for (std::uint16_t i = 0; i < count; ++i) {
+                    const auto value = static_cast<std::uint16_t>(address + i);
+                    response.push_back(static_cast<std::uint8_t>(value >> 8));
+                    response.push_back(static_cast<std::uint8_t>(value));
+                }
+            }
+            const auto pdu = response.size() - 6;
+            response[4] = static_cast<std::uint8_t>(pdu >> 8);
+            response[5] = static_cast<std::uint8_t>(pdu);
+            boost::asio::write(socket, boost::asio::buffer(response), ec);
+            if (ec) {
+                return;
+            }
+        }
+    }
+
+    boost::asio::io_context context_;
+    tcp::acceptor acceptor_;
+    std::thread thread_;
+};
+
+ModbusRequest read(std::uint16_t address, std::uint16_t count) {
+    ModbusRequest request;
+    request.slaveId = 1;
+    request.function = FunctionCode::ReadHoldingRegisters;
+    request.startAddress = address;
+    request.count = count;
+    return request;
+}
+
+ModbusRequest writeOne(std::uint16_t address, std::uint16_t value) {
+    ModbusRequest request;
+    request.slaveId = 1;
+    request.function = FunctionCode::WriteSingleRegister;
+    request.startAddress = address;
+    request.values = {value};
+    return request;
+}
+
+// Responses are matched on a scheduler strand; the procedure must still resume on the executor it
+// was spawned on.
+boost::asio::awaitable<void> readWriteAndGroup(ApplicationCore& core) {
+    const auto executor = core.scheduler().executor();
+    const auto outcome = co_await application::co_read(core, read(10, 3));
+    CHECK(executor.running_in_this_thread());
+    CHECK(outcome.ok);
+    CHECK(outcome.result.values.size() == 3 && outcome.result.values[2] == 12);
+
+    const auto written = co_await application::co_write(core, writeOne(20, 7));
+    CHECK(executor.running_in_this_thread());
+    CHECK(written.ok);
+
+    std::vector<ModbusRequest> items;
+    items.push_back(read(0, 2));
+    items.push_back(read(4, 2));
+    const auto group = co_await application::co_read_group(core, std::move(items));
+    CHECK(executor.running_in_this_thread());
+    CHECK(group.ok);
+    CHECK(group.results.size() == 2 && group.results[1].values[0] == 4);
+}
+
+void resumesOnTheSchedulerExecutor() {
+    FakeSlave slave;
+    transport::TransportOptions options;
+    transport::TransportManager transportManager(options);
+    ApplicationCore core(transportManager, 2);
+    std::string error;
+    CHECK(core.openTcpTransport("127.0.0.1", slave.port(), error));
+
+    std::promise<void> done;
+    boost::asio::co_spawn(core.scheduler().executor(), readWriteAndGroup(core),
+                          [&done](std::exception_ptr) { done.set_value(); });
+    CHECK(done.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+    boost::json::object closed;
+    core.closeActiveTransport(closed);
+}
+
+// Spawned outside the scheduler, a procedure must not be resumed on the strand that matched the
+// response. Without a session the request fails inline, inside co_read itself, and that outcome is
+// posted to the procedure's executor as well.
+boost::asio::awaitable<void> readFromAnotherExecutor(ApplicationCore& core, boost::asio::io_context& context,
+                                                     bool& finished) {
+    const auto outcome = co_await application::co_read(core, read(10, 1));
+    CHECK(context.get_executor().running_in_this_thread());
+    CHECK(!core.scheduler().executor().running_in_this_thread());
+    CHECK(outcome.ok);
+
+    boost::json::object closed;
+    core.closeActiveTransport(closed);
+    const auto failed = co_await application::co_read(core, read(0, 1));
+    CHECK(context.get_executor().running_in_this_thread());
+    CHECK(!failed.ok);
+    CHECK(failed.error == "No active device session");
+
+    const auto written = co_await application::co_write(core, writeOne(0, 1));
+    CHECK(!written.ok);
+    finished = true;
+}
+
+void resumesOnTheCallersExecutor() {
+    FakeSlave slave;
+    transport::TransportOptions options;
+    transport::TransportManager transportManager(options);
+    ApplicationCore core(transportManager, 2);
+    std::string error;
+    CHECK(core.openTcpTransport("127.0.0.1", slave.port(), error));
+
+    boost::asio::io_context context;
+    bool finished = false;
+    boost::asio::co_spawn(context, readFromAnotherExecutor(core, context, finished), boost::asio::detached);
+    context.run();
+    CHECK(finished);
+}
+
+} // namespace
+
+int main() {
+    resumesOnTheSchedulerExecutor();
+    resumesOnTheCallersExecutor();
+    return tests::result("CoroutinesTest");
+}
@@ -0,0 +1,142 @@
+#include "Check.h"
+#include "layers/application/ReadPlanner.h"
+
+namespace {
+
+using application::PlannedRead;
+using application::ReadPlanner;
+using protocol::FunctionCode;
+using protocol::ModbusRequest;
+
+ModbusRequest read(std::uint16_t address, std::uint16_t count, std::uint8_t slave = 1,
+                   FunctionCode function = FunctionCode::ReadHoldingRegisters) {
+    ModbusRequest request;
+    request.slaveId = slave;
+    request.function = function;
+    request.startAddress = address;
+    request.count = count;
+    return request;
+}
+
+// Plans on a link where bridging any gap up to the hard limit pays off.
+std::vector<PlannedRead> plan(std::uint16_t gapLimit, const std::vector<ModbusRequest>& items) {
+    ReadPlanner planner;
+    planner.configureLink(1.0, 1000.0);
+    planner.setGapLimit(gapLimit);
+    return planner.plan(items);
+}
+
+void mergesAdjacentAndOverlapping() {
+    const auto planned = plan(0, {read(0, 10), read(10, 10), read(15, 10)});
+    CHECK(planned.size() == 1);
+    CHECK(planned[0].request.startAddress == 0);
+    CHECK(planned[0].request.count == 25);
+    CHECK((planned[0].items == std::vector<std::size_t>{0, 1, 2}));
+}
+
+void bridgesGapsUpToTheLimit() {
+    const auto bridged = plan(5, {read(0, 10), read(15, 10)});
+    CHECK(bridged.size() == 1);
+    CHECK(bridged[0].request.count == 25);
+
+    const auto apart = plan(5, {read(0, 10), read(16, 10)});
+    CHECK(apart.size() == 2);
+
+    const auto noGap = plan(0, {read(0, 10), read(11, 10)});
+    CHECK(noGap.size() == 2);
+}
+
+void gapFollowsTheCostModel() {
+    ReadPlanner model;
+    model.setGapLimit(100);
+    model.configureLink(2.0, 20.0);  // one more exchange costs as much as 10 registers
+    CHECK(model.maxGap() == 10);
+    CHECK(model.plan({read(0, 5), read(15, 5)}).size() == 1);
+    CHECK(model.plan({read(0, 5), read(16, 5)}).size() == 2);
+
+    model.setGapLimit(1000);
+    CHECK(model.stats().maxGap == 10);
+    model.configureLink(0.001, 1e9);
+    CHECK(model.maxGap() == protocol::kMaxReadRegisters);
+}
+
+void neverExceedsOneRequest() {
+    const auto full = plan(32, {read(0, 100), read(100, 25)});
+    CHECK(full.size() == 1);
+    CHECK(full[0].request.count == protocol::kMaxReadRegisters);
+
+    const auto over = plan(32, {read(0, 100), read(100, 26)});
+    CHECK(over.size() == 2);
+    for (const auto& planned : over) {
+        CHECK(planned.request.count <= protocol::kMaxReadRegisters);
+    }
+
+    // A bridged gap counts against the limit as well.
+    const auto gapped = plan(32, {read(0, 100), read(120, 10)});
+    CHECK(gapped.size() == 2);
+}
+
+void reachesTheTopOfTheAddressSpace() {
+    const auto planned = plan(32, {read(0xFFF0, 8), read(0xFFF8, 8)});
+    CHECK(planned.size() == 1);
+    CHECK(planned[0].request.startAddress == 0xFFF0);
+    CHECK(planned[0].request.count == 16);
+}
+
+void keepsDevicesAndTablesApart() {
+    const auto planned = plan(32, {read(0, 10, 1), read(10, 10, 2), read(20, 10, 1, FunctionCode::ReadInputRegisters)});
+    CHECK(planned.size() == 3);
+}
+
+void passesUnmergeableItemsThrough() {
+    ModbusRequest write = read(0, 1);
+    write.function = FunctionCode::WriteSingleRegister;
+    const auto planned = plan(32, {read(0, 0), read(0, 126), write, read(0, 10)});
+    CHECK(planned.size() == 4);
+    CHECK(planned[1].request.count == 126);
+}
+
+void keepsTheCallersOrder() {
+    const auto planned = plan(0, {read(100, 5, 2), read(50, 5), read(0, 5), read(55, 5)});
+    CHECK(planned.size() == 3);
+    CHECK((planned[0].items == std::vector<std::size_t>{0}));
+    CHECK((planned[1].items == std::vector<std::size_t>{1, 3}));
+    CHECK((planned[2].items == std::vector<std::size_t>{2}));
+}
+
+void extractsItemsFromAMergedRead() {
+    application::ReadResult merged;
+    merged.slaveId = 3;
+    merged.address = 100;
+    merged.count = 10;
+    for (std::uint16_t i = 0; i < 10; ++i) {
+        merged.values.push_back(static_cast<std::uint16_t>(1000 + i));
+    }
+
+    application::ReadResult out;
+    CHECK(ReadPlanner::extract(merged, read(104, 3), out));
+    CHECK(out.slaveId == 3);
+    CHECK(out.address == 104);
+    CHECK(out.values.size() == 3);
+    CHECK(out.values[0] == 1004);
+    CHECK(out.values[2] == 1006);
+
+    CHECK(ReadPlanner::extract(merged, read(100, 10), out));
+    CHECK(!ReadPlanner::extract(merged, read(99, 2), out));
+    CHECK(!ReadPlanner::extract(merged, read(105, 6), out));
+}
+
+} // namespace
+
+int main() {
+    mergesAdjacentAndOverlapping();
+    bridgesGapsUpToTheLimit();
+    gapFollowsTheCostModel();
+    neverExceedsOneRequest();
+    reachesTheTopOfTheAddressSpace();
+    keepsDevicesAndTablesApart();
+    passesUnmergeableItemsThrough();
+    keepsTheCallersOrder();
+    extractsItemsFromAMergedRead();
+    return tests::result("ReadPlannerTest");
+}
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include "Check.h"
+#include "crc.hpp"
+#include "layers/protocol/protocol_layer.h"
+
+// Every heap allocation of the process goes through here; only those made while `counting` is set
+// are counted, so the test can bracket exactly the decode calls.
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> allocations{0};
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using protocol::ModbusResponse;
+using protocol::ProtocolHandler;
+using transport::ConnectionType;
+
+constexpr std::size_t kFrames = 2000;
+
+// A holding-register read response of `registers` values, as a TCP or RTU ADU.
+void appendFrame(std::vector<std::uint8_t>& out, ConnectionType type, std::uint16_t transactionId, std::uint16_t registers,
+                 std::mt19937& rng) {
+    const auto start = out.size();
+    const auto byteCount = static_cast<std::uint8_t>(registers * 2);
+    if (type == ConnectionType::Tcp) {
+        const auto length = static_cast<std::uint16_t>(3 + byteCount);
+        out.insert(out.end(), {static_cast<std::uint8_t>(transactionId >> 8), static_cast<std::uint8_t>(transactionId), 0, 0,
+                               static_cast<std::uint8_t>(length >> 8), static_cast<std::uint8_t>(length)});
+    }
+    out.insert(out.end(), {1, static_cast<std::uint8_t>(protocol::FunctionCode::ReadHoldingRegisters), byteCount});
+    for (std::uint16_t i = 0; i < byteCount; ++i) {
+        out.push_back(static_cast<std::uint8_t>(rng()));
+    }
+    if (type == ConnectionType::Rtu) {
+        const auto crc = MB::CRC::calculateCRC(out.data() + start, out.size() - start);
+        out.push_back(static_cast<std::uint8_t>(crc & 0xFF));
+        out.push_back(static_cast<std::uint8_t>(crc >> 8));
+    }
+}
+
+// Feeds kFrames responses in chunks of `minChunk..maxChunk` bytes and counts what the decoder allocates.
+void decodesWithoutAllocating(ConnectionType type, std::size_t minChunk, std::size_t maxChunk) {
+    std::mt19937 rng(7);
+    std::vector<std::uint8_t> stream;
+    std::uniform_int_distribution<int> registers(1, protocol::kMaxReadRegisters);
+    for (std::size_t i = 0; i < kFrames; ++i) {
+        appendFrame(stream, type, static_cast<std::uint16_t>(i), static_cast<std::uint16_t>(registers(rng)), rng);
+    }
+    std::vector<std::size_t> chunks;
+    std::uniform_int_distribution<std::size_t> chunkSize(minChunk, maxChunk);
+    for (std::size_t done = 0; done < stream.size();) {
+        chunks.push_back(std::min(chunkSize(rng), stream.size() - done));
+        done += chunks.back();
+    }
+
+    ProtocolHandler handler;
+    const auto decoder = handler.createDecoder(type);
+    std::size_t frames = 0;
+    const ProtocolHandler::ResponseHandler onResponse = [&frames](const ModbusResponse&) { ++frames; };
+
+    allocations = 0;
+    counting = true;
+    std::size_t offset = 0;
+    for (const auto size : chunks) {
+        handler.processIncomingBuffer(*decoder, transport::ByteSpan{stream.data() + offset, size}, onResponse);
+        offset += size;
+    }
+    counting = false;
+
+    CHECK(frames == kFrames);
+    CHECK(allocations == 0);
+    CHECK(handler.receiveStats().decodersCreated == 1);
+    CHECK(handler.receiveStats().overflowBytes == 0);
+}
+
+} // namespace
+
+int main() {
+    for (const auto type : {ConnectionType::Tcp, ConnectionType::Rtu}) {
+        decodesWithoutAllocating(type, 1, 16);      // frames split across many reads
+        decodesWithoutAllocating(type, 2048, 2048);  // full receive buffers, many frames per read
+        decodesWithoutAllocating(type, 1, 2048);
+    }
+    return tests::result("ReceivePathTest");
+}
@@ -0,0 +1,148 @@
+#include "Check.h"
+#include "layers/application/RegisterCache.h"
+
+namespace {
+
+using application::RegisterCache;
+using application::RegisterRange;
+using protocol::FunctionCode;
+using Clock = RegisterCache::Clock;
+
+constexpr std::chrono::milliseconds kFresh{60000};
+
+bool sameRanges(const std::vector<RegisterRange>& actual, const std::vector<RegisterRange>& expected) {
+    if (actual.size() != expected.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+        if (actual[i].address != expected[i].address || actual[i].count != expected[i].count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void emptyCacheMissesEverything() {
+    RegisterCache cache;
+    std::uint16_t out[4] = {9, 9, 9, 9};
+    CHECK(sameRanges(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 10, 4, kFresh, out), {{10, 4}}));
+    CHECK(out[0] == 0 && out[3] == 0);
+}
+
+void servesStoredValues() {
+    RegisterCache cache;
+    const std::uint16_t values[] = {1, 2, 3, 4};
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 10, values, 4);
+
+    std::uint16_t out[4] = {};
+    CHECK(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 10, 4, kFresh, out).empty());
+    CHECK(out[0] == 1 && out[3] == 4);
+
+    // Only the registers outside the stored block are fetched, as contiguous ranges.
+    std::uint16_t wide[8] = {};
+    CHECK(sameRanges(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 8, 8, kFresh, wide), {{8, 2}, {14, 2}}));
+    CHECK(wide[2] == 1 && wide[5] == 4);
+}
+
+void spansPages() {
+    RegisterCache cache;
+    std::vector<std::uint16_t> values(100);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<std::uint16_t>(i);
+    }
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 40, values.data(), values.size());
+    CHECK(cache.pageCount() == 3);
+
+    std::vector<std::uint16_t> out(100);
+    CHECK(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 40, 100, kFresh, out.data()).empty());
+    CHECK(out == values);
+}
+
+void reachesTheTopOfTheAddressSpace() {
+    RegisterCache cache;
+    const std::uint16_t values[] = {7, 8, 9};
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 0xFFFE, values, 3);  // the third register does not exist
+
+    std::uint16_t out[2] = {};
+    CHECK(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 0xFFFE, 2, kFresh, out).empty());
+    CHECK(out[0] == 7 && out[1] == 8);
+    CHECK(sameRanges(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 0, 1, kFresh, out), {{0, 1}}));
+}
+
+void keepsSlavesAndTablesApart() {
+    RegisterCache cache;
+    const std::uint16_t value = 42;
+    cache.store(1, FunctionCode::ReadInputRegisters, 5, &value, 1);
+
+    std::uint16_t out = 0;
+    CHECK(cache.lookup(1, FunctionCode::ReadInputRegisters, 5, 1, kFresh, &out).empty());
+    CHECK(!cache.lookup(1, FunctionCode::ReadHoldingRegisters, 5, 1, kFresh, &out).empty());
+    CHECK(!cache.lookup(2, FunctionCode::ReadInputRegisters, 5, 1, kFresh, &out).empty());
+
+    // A write echo lands in the holding table.
+    cache.store(1, FunctionCode::WriteSingleRegister, 5, &value, 1);
+    CHECK(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 5, 1, kFresh, &out).empty());
+}
+
+void olderThanMaxAgeIsRefetched() {
+    RegisterCache cache;
+    const std::uint16_t values[] = {1, 2};
+    const auto now = Clock::now();
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 0, values, 1, now - std::chrono::seconds(5));
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 1, values + 1, 1, now);
+
+    std::uint16_t out[2] = {};
+    CHECK(sameRanges(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 0, 2, std::chrono::seconds(1), out), {{0, 1}}));
+    CHECK(out[1] == 2);
+    CHECK(cache.lookup(1, FunctionCode::ReadHoldingRegisters, 0, 2, std::chrono::seconds(10), out).empty());
+}
+
+void ttlBoundsEveryLookup() {
+    RegisterCache cache;
+    cache.setTtl(std::chrono::seconds(1));
+    const std::uint16_t value = 1;
+    const auto now = Clock::now();
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 0, &value, 1, now - std::chrono::seconds(2));
+    cache.store(1, FunctionCode::ReadHoldingRegisters, 100, &value, 1, now);
+
+    std::uint16_t out = 0;
+    CHECK(!cache.lookup(1, FunctionCode::ReadHoldingRegisters, 0, 1, kFresh, &out).empty());
+    CHECK(cache.pageCount() == 2);
+    CHECK(cache.prune(now) == 1);
+    CHECK(cache.pageCount() == 1);
+
+    cache.clear();
+    CHECK(cache.pageCount() == 0);
+}
+
+void countsHitsAndMisses() {
+    RegisterCache cache;
+    const std::uint16_t values[] = {1, 2};
+    cache.store(3, FunctionCode::ReadHoldingRegisters, 0, values, 2);
+
+    std::uint16_t out[4] = {};
+    cache.lookup(3, FunctionCode::ReadHoldingRegisters, 0, 2, kFresh, out);
+    cache.lookup(3, FunctionCode::ReadHoldingRegisters, 0, 4, kFresh, out);
+
+    const auto stats = cache.stats();
+    CHECK(stats.size() == 1);
+    CHECK(stats[0].slaveId == 3);
+    CHECK(stats[0].hits == 1);
+    CHECK(stats[0].misses == 1);
+    CHECK(stats[0].registersFromCache == 4);
+    CHECK(stats[0].registersFetched == 2);
+}
+
+} // namespace
+
+int main() {
+    emptyCacheMissesEverything();
+    servesStoredValues();
+    spansPages();
+    reachesTheTopOfTheAddressSpace();
+    keepsSlavesAndTablesApart();
+    olderThanMaxAgeIsRefetched();
+    ttlBoundsEveryLookup();
+    countsHitsAndMisses();
+    return tests::result("RegisterCacheTest");
+}
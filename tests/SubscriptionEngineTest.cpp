@@ -0,0 +1,267 @@
+#include <future>
+#include <thread>
+
+#include "Check.h"
+#include "layers/application/SubscriptionEngine.h"
+
+namespace {
+
+using application::ChangeReport;
+using application::DeadbandMode;
+using application::ReadResult;
+using application::SubscriptionConfig;
+using application::SubscriptionEngine;
+using application::TaskScheduler;
+using protocol::FunctionCode;
+
+// An engine on its own scheduler, with a sink that keeps every report.
+class Fixture {
+public:
+    Fixture() : engine_(scheduler_) {
+        engine_.addSink([this](const ChangeReport& report) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reports_.push_back(report);
+        });
+    }
+
+    ~Fixture() {
+        engine_.stop();
+        scheduler_.stop();
+    }
+
+    std::uint64_t subscribe(SubscriptionConfig config) {
+        std::uint64_t id = 0;
+        std::string error;
+        CHECK(engine_.add(config, id, error));
+        return id;
+    }
+
+    void ingest(std::uint16_t address, std::vector<std::uint16_t> values, std::uint8_t slave = 1,
+                FunctionCode function = FunctionCode::ReadHoldingRegisters) {
+        ReadResult update{slave, function, address, static_cast<std::uint16_t>(values.size()), {}};
+        for (const auto value : values) {
+            update.values.push_back(value);
+        }
+        engine_.ingest(update);
+    }
+
+    // Reports reach the sink on the engine's strand, so a task queued behind them sees all of them.
+    std::vector<ChangeReport> reports() {
+        std::promise<void> done;
+        scheduler_.post(SubscriptionEngine::kStrandKey, [&done]() { done.set_value(); });
+        done.get_future().wait();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reports_;
+    }
+
+    // Values of the latest report, or empty if the count has not grown past `seen`.
+    std::vector<std::uint16_t> newValues(std::size_t& seen) {
+        const auto all = reports();
+        std::vector<std::uint16_t> values;
+        if (all.size() > seen) {
+            for (const auto& change : all.back().changes) {
+                values.push_back(change.value);
+            }
+        }
+        seen = all.size();
+        return values;
+    }
+
+    SubscriptionEngine& engine() { return engine_; }
+
+private:
+    TaskScheduler scheduler_{2};
+    SubscriptionEngine engine_;
+    std::mutex mutex_;
+    std::vector<ChangeReport> reports_;
+};
+
+SubscriptionConfig config(std::uint16_t address, std::uint16_t count, DeadbandMode mode = DeadbandMode::Absolute,
+                          double deadband = 0.0) {
+    SubscriptionConfig config;
+    config.address = address;
+    config.count = count;
+    config.deadbandMode = mode;
+    config.deadband = deadband;
+    return config;
+}
+
+void firstSampleIsReported() {
+    Fixture fixture;
+    fixture.subscribe(config(10, 3, DeadbandMode::Absolute, 1000.0));
+    fixture.ingest(10, {0, 0, 0});
+
+    const auto reports = fixture.reports();
+    CHECK(reports.size() == 1);
+    CHECK(reports[0].changes.size() == 3);
+    CHECK(!reports[0].heartbeat);
+
+    // Unchanged values are not reported again.
+    fixture.ingest(10, {0, 0, 0});
+    CHECK(fixture.reports().size() == 1);
+}
+
+void absoluteDeadband() {
+    Fixture fixture;
+    fixture.subscribe(config(0, 1, DeadbandMode::Absolute, 5.0));
+    std::size_t seen = 0;
+    fixture.ingest(0, {100});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{100}));
+
+    fixture.ingest(0, {105});
+    CHECK(fixture.newValues(seen).empty());
+    fixture.ingest(0, {95});
+    CHECK(fixture.newValues(seen).empty());
+
+    // Measured from the last reported value, so slow drift is reported once it adds up.
+    fixture.ingest(0, {106});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{106}));
+    fixture.ingest(0, {0});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{0}));
+}
+
+void percentDeadband() {
+    Fixture fixture;
+    fixture.subscribe(config(0, 1, DeadbandMode::Percent, 10.0));
+    std::size_t seen = 0;
+    fixture.ingest(0, {100});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{100}));
+
+    fixture.ingest(0, {110});
+    CHECK(fixture.newValues(seen).empty());
+    fixture.ingest(0, {111});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{111}));
+
+    // 10% of 111 is 11.1: a move of 11 stays inside, 12 leaves it.
+    fixture.ingest(0, {100});
+    CHECK(fixture.newValues(seen).empty());
+    fixture.ingest(0, {99});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{99}));
+}
+
+void percentDeadbandAtZero() {
+    Fixture fixture;
+    fixture.subscribe(config(0, 1, DeadbandMode::Percent, 50.0));
+    std::size_t seen = 0;
+    fixture.ingest(0, {0});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{0}));
+
+    // A percentage of zero is zero, so every move away from zero is reported.
+    fixture.ingest(0, {0});
+    CHECK(fixture.newValues(seen).empty());
+    fixture.ingest(0, {1});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{1}));
+
+    // 50% of 1 rounds down to a zero band as well.
+    fixture.ingest(0, {2});
+    CHECK((fixture.newValues(seen) == std::vector<std::uint16_t>{2}));
+    fixture.ingest(0, {3});
+    CHECK(fixture.newValues(seen).empty());
+}
+
+void reportsOnlyRegistersOutsideTheirBand() {
+    Fixture fixture;
+    fixture.subscribe(config(10, 4, DeadbandMode::Absolute, 2.0));
+    fixture.ingest(10, {0, 0, 0, 0});
+    fixture.ingest(10, {1, 5, 2, 3});
+
+    const auto reports = fixture.reports();
+    CHECK(reports.size() == 2);
+    CHECK(reports[1].changes.size() == 2);
+    CHECK(reports[1].changes[0].address == 11);
+    CHECK(reports[1].changes[0].value == 5);
+    CHECK(reports[1].changes[1].address == 13);
+}
+
+void blocksOnlyTouchTheirOverlap() {
+    Fixture fixture;
+    fixture.subscribe(config(10, 4));
+    fixture.ingest(0, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});  // covers 10 and 11 only
+    fixture.ingest(13, {1}, 2);                                  // another slave
+    fixture.ingest(13, {1}, 1, FunctionCode::ReadInputRegisters);  // another table
+
+    const auto reports = fixture.reports();
+    CHECK(reports.size() == 1);
+    CHECK(reports[0].changes.size() == 2);
+    CHECK(reports[0].changes[0].address == 10);
+    CHECK(reports[0].changes[0].value == 11);
+}
+
+void minIntervalHoldsAndMerges() {
+    Fixture fixture;
+    auto held = config(0, 1);
+    held.minInterval = std::chrono::milliseconds(100);
+    fixture.subscribe(held);
+
+    // The interval starts at subscription, so these changes are held and merged into one report.
+    fixture.ingest(0, {1});
+    fixture.ingest(0, {2});
+    fixture.ingest(0, {3});
+    CHECK(fixture.reports().empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    const auto reports = fixture.reports();
+    CHECK(reports.size() == 1);
+    CHECK(!reports.empty() && reports[0].changes.size() == 1 && reports[0].changes[0].value == 3);
+}
+
+void heartbeatRepeatsKnownRegisters() {
+    Fixture fixture;
+    auto beating = config(0, 2);
+    beating.maxInterval = std::chrono::milliseconds(50);
+    fixture.subscribe(beating);
+    fixture.ingest(0, {7});  // register 1 is never seen
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const auto reports = fixture.reports();
+    CHECK(reports.size() >= 2);
+    CHECK(!reports.front().heartbeat);
+    CHECK(reports.back().heartbeat);
+    CHECK(reports.back().changes.size() == 1);
+    CHECK(reports.back().changes[0].value == 7);
+}
+
+void rejectsInvalidConfigs() {
+    Fixture fixture;
+    std::uint64_t id = 0;
+    std::string error;
+    CHECK(!fixture.engine().add(config(0xFFFF, 2), id, error));
+    CHECK(!fixture.engine().add(config(0, 1, DeadbandMode::Absolute, -1.0), id, error));
+
+    auto write = config(0, 1);
+    write.function = FunctionCode::WriteSingleRegister;
+    CHECK(!fixture.engine().add(write, id, error));
+
+    auto intervals = config(0, 1);
+    intervals.minInterval = std::chrono::milliseconds(100);
+    intervals.maxInterval = std::chrono::milliseconds(50);
+    CHECK(!fixture.engine().add(intervals, id, error));
+}
+
+void removedSubscriptionsGoQuiet() {
+    Fixture fixture;
+    const auto id = fixture.subscribe(config(0, 1));
+    CHECK(fixture.engine().active());
+    CHECK(fixture.engine().remove(id));
+    CHECK(!fixture.engine().active());
+    CHECK(!fixture.engine().remove(id));
+
+    fixture.ingest(0, {1});
+    CHECK(fixture.reports().empty());
+}
+
+} // namespace
+
+int main() {
+    firstSampleIsReported();
+    absoluteDeadband();
+    percentDeadband();
+    percentDeadbandAtZero();
+    reportsOnlyRegistersOutsideTheirBand();
+    blocksOnlyTouchTheirOverlap();
+    minIntervalHoldsAndMerges();
+    heartbeatRepeatsKnownRegisters();
+    rejectsInvalidConfigs();
+    removedSubscriptionsGoQuiet();
+    return tests::result("SubscriptionEngineTest");
+}
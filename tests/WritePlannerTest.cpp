@@ -0,0 +1,131 @@
+#include "Check.h"
+#include "layers/application/WritePlanner.h"
+
+namespace {
+
+using application::PlannedWrite;
+using application::WritePlanner;
+using protocol::FunctionCode;
+using protocol::ModbusRequest;
+
+ModbusRequest writeSingle(std::uint16_t address, std::uint16_t value, std::uint8_t slave = 1) {
+    ModbusRequest request;
+    request.slaveId = slave;
+    request.function = FunctionCode::WriteSingleRegister;
+    request.startAddress = address;
+    request.count = 1;
+    request.values = {value};
+    return request;
+}
+
+ModbusRequest writeMultiple(std::uint16_t address, std::vector<std::uint16_t> values, std::uint8_t slave = 1) {
+    ModbusRequest request;
+    request.slaveId = slave;
+    request.function = FunctionCode::WriteMultipleRegisters;
+    request.startAddress = address;
+    request.count = static_cast<std::uint16_t>(values.size());
+    request.values = std::move(values);
+    return request;
+}
+
+// Values start, start + 1, ... so every register of a run can be told apart.
+std::vector<std::uint16_t> sequence(std::uint16_t start, std::size_t count) {
+    std::vector<std::uint16_t> values(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = static_cast<std::uint16_t>(start + i);
+    }
+    return values;
+}
+
+void mergesAdjacentSingleWrites() {
+    const auto planned = WritePlanner::plan({writeSingle(11, 2), writeSingle(10, 1), writeSingle(12, 3)});
+    CHECK(planned.size() == 1);
+    CHECK(planned[0].request.function == FunctionCode::WriteMultipleRegisters);
+    CHECK(planned[0].request.startAddress == 10);
+    CHECK(planned[0].request.count == 3);
+    CHECK((planned[0].request.values == std::vector<std::uint16_t>{1, 2, 3}));
+    CHECK((planned[0].items == std::vector<std::size_t>{0, 1, 2}));
+}
+
+void lastWriterWins() {
+    const auto planned = WritePlanner::plan({writeMultiple(10, {1, 2, 3}), writeSingle(11, 9), writeMultiple(12, {7, 8})});
+    CHECK(planned.size() == 1);
+    CHECK((planned[0].request.values == std::vector<std::uint16_t>{1, 9, 7, 8}));
+
+    // An item whose registers are all overwritten later contributes to no frame.
+    const auto shadowed = WritePlanner::plan({writeSingle(5, 1), writeSingle(5, 2)});
+    CHECK(shadowed.size() == 1);
+    CHECK((shadowed[0].request.values == std::vector<std::uint16_t>{2}));
+    CHECK((shadowed[0].items == std::vector<std::size_t>{1}));
+}
+
+void loneRegisterKeepsItsFunction() {
+    const auto single = WritePlanner::plan({writeSingle(5, 1)});
+    CHECK(single.size() == 1);
+    CHECK(single[0].request.function == FunctionCode::WriteSingleRegister);
+
+    const auto multiple = WritePlanner::plan({writeMultiple(5, {1})});
+    CHECK(multiple.size() == 1);
+    CHECK(multiple[0].request.function == FunctionCode::WriteMultipleRegisters);
+
+    // The function follows whoever wrote the register last.
+    const auto overwritten = WritePlanner::plan({writeMultiple(5, {1}), writeSingle(5, 2)});
+    CHECK(overwritten.size() == 1);
+    CHECK(overwritten[0].request.function == FunctionCode::WriteSingleRegister);
+}
+
+void splitsAtTheFrameLimit() {
+    const auto planned = WritePlanner::plan({writeMultiple(0, sequence(0, 100)), writeMultiple(100, sequence(100, 50))});
+    CHECK(planned.size() == 2);
+    CHECK(planned[0].request.startAddress == 0);
+    CHECK(planned[0].request.count == protocol::kMaxWriteRegisters);
+    CHECK(planned[0].request.values.back() == protocol::kMaxWriteRegisters - 1);
+    CHECK(planned[1].request.startAddress == protocol::kMaxWriteRegisters);
+    CHECK(planned[1].request.count == 150 - protocol::kMaxWriteRegisters);
+    CHECK((planned[1].items == std::vector<std::size_t>{1}));
+
+    const auto exact = WritePlanner::plan({writeMultiple(0, sequence(0, 100)), writeMultiple(100, sequence(100, 23))});
+    CHECK(exact.size() == 1);
+}
+
+void keepsGapsAndSlavesApart() {
+    CHECK(WritePlanner::plan({writeSingle(10, 1), writeSingle(12, 2)}).size() == 2);
+    CHECK(WritePlanner::plan({writeSingle(10, 1, 1), writeSingle(11, 2, 2)}).size() == 2);
+}
+
+void passesUnmergeableItemsThrough() {
+    auto read = writeSingle(0, 0);
+    read.function = FunctionCode::ReadHoldingRegisters;
+    auto emptySingle = writeSingle(1, 0);
+    emptySingle.values.clear();
+
+    const auto planned = WritePlanner::plan(
+        {writeMultiple(0, sequence(0, 124)), read, emptySingle, writeMultiple(0xFFFF, {1, 2}), writeMultiple(0xFFFE, {1, 2})});
+    CHECK(planned.size() == 5);
+    CHECK(planned[0].request.count == 124);
+    CHECK(planned[1].request.function == FunctionCode::ReadHoldingRegisters);
+    CHECK(planned[3].request.startAddress == 0xFFFF);
+    CHECK(planned[4].request.startAddress == 0xFFFE);
+    CHECK(planned[4].request.count == 2);
+}
+
+void sendsInSubmissionOrder() {
+    const auto planned = WritePlanner::plan({writeSingle(50, 1, 2), writeSingle(100, 1), writeSingle(0, 1), writeSingle(101, 2)});
+    CHECK(planned.size() == 3);
+    CHECK((planned[0].items == std::vector<std::size_t>{0}));
+    CHECK((planned[1].items == std::vector<std::size_t>{1, 3}));
+    CHECK((planned[2].items == std::vector<std::size_t>{2}));
+}
+
+} // namespace
+
+int main() {
+    mergesAdjacentSingleWrites();
+    lastWriterWins();
+    loneRegisterKeepsItsFunction();
+    splitsAtTheFrameLimit();
+    keepsGapsAndSlavesApart();
+    passesUnmergeableItemsThrough();
+    sendsInSubmissionOrder();
+    return tests::result("WritePlannerTest");
+}